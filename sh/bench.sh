@@ -0,0 +1,20 @@
+#!/bin/bash
+
+CONFIG_FILE="config.xml"
+
+PATH_TO_THIS="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+PATH_TO_LIB_ROOT="$(dirname ${PATH_TO_THIS})"
+PATH_TO_TEST_DEPS="$( xmlstarlet sel -t -v "config/test/deps/@Dest" ${CONFIG_FILE})"
+PATH_TO_TEST_DEP_DYN_LIBS=${PATH_TO_LIB_ROOT}/${PATH_TO_TEST_DEPS}/lib
+
+export LD_LIBRARY_PATH=${PATH_TO_TEST_DEP_DYN_LIBS}
+
+for BENCH_EXE in ./test/exe/bench_*
+do
+    echo
+    echo "*******************************"
+    echo "Running '$(basename ${BENCH_EXE})' benchmark."
+    echo "*******************************"
+
+    ${BENCH_EXE}
+done
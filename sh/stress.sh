@@ -0,0 +1,24 @@
+#!/bin/bash
+
+CONFIG_FILE="config.xml"
+
+PATH_TO_THIS="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+PATH_TO_LIB_ROOT="$(dirname ${PATH_TO_THIS})"
+PATH_TO_TEST_DEPS="$( xmlstarlet sel -t -v "config/test/deps/@Dest" ${CONFIG_FILE})"
+PATH_TO_TEST_DEP_DYN_LIBS=${PATH_TO_LIB_ROOT}/${PATH_TO_TEST_DEPS}/lib
+
+export LD_LIBRARY_PATH=${PATH_TO_TEST_DEP_DYN_LIBS}
+
+STRESS_RESULT=0
+
+for STRESS_EXE in ./test/exe/stress_*
+do
+    echo
+    echo "*******************************"
+    echo "Running '$(basename ${STRESS_EXE})' stress test."
+    echo "*******************************"
+
+    ${STRESS_EXE} || STRESS_RESULT=1
+done
+
+exit ${STRESS_RESULT}
@@ -14,9 +14,17 @@
 #include <syslog.h>
 #include <pthread.h>
 #include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/uio.h>
 #include "MutexGuard_api.h"
 #include "SignalHandler_api.h"
 #include "SeverityLog_api.h"
+#include "SeverityLogUring.h"
+#include "SeverityLogShm.h"
+#include "SeverityLogPerCpu.h"
+#include "SeverityLogFile.h"
 
 /************************************/
 
@@ -33,6 +41,7 @@
 #define SVRTY_MSG_INIT      "SeverityLog has been properly initialized."
 #define SVRTY_MSG_CLEANUP   "Freeing SeverityLog's resources."
 #define SVRTY_MSG_SIGNAL    "Received <%s> signal."
+#define SVRTY_MSG_SPAN      "Span <%s> took %" PRIu64 " ns."
 
 #define SVRTY_LOG_STR_DEFAULT_SIZE  10000
 
@@ -46,6 +55,8 @@
 #define SVRTY_TIME_DATE_STR_SIZE    128
 #define SVRTY_FILE_NAME_STR_SIZE    100
 #define SVRTY_LOGGING_TID           21
+#define SVRTY_SAMPLING_STR_SIZE     16
+#define SVRTY_CONTEXT_STR_SIZE      256
 
 #define SVRTY_STR_ERR       "[ERR] "
 #define SVRTY_STR_INF       "[INF] "
@@ -59,6 +70,30 @@
 #define SVRTY_LOG_UNINITIALIZED     -1
 #define SVRTY_LOG_WNG_SILENT_LVL    -2
 #define SVRTY_LOG_ALLOCATION_ERR    -3
+#define SVRTY_LOG_WNG_SHORT_SPAN    -4
+#define SVRTY_LOG_WNG_SAMPLED_OUT   -5
+#define SVRTY_LOG_INVALID_LVL       -6
+// SVRTY_LOG_BATCH_FULL (-7) is public (see SeverityLog_api.h).
+#define SVRTY_LOG_BATCH_INVALID     -8
+
+#define SVRTY_LOG_INVALID_BACKEND   -9
+#define SVRTY_LOG_SHM_ERR           -10
+#define SVRTY_LOG_PERCPU_ERR        -11
+#define SVRTY_LOG_WNG_DROPPED       -12
+#define SVRTY_LOG_INVALID_POLICY    -13
+#define SVRTY_LOG_CONTEXT_FULL      -14
+#define SVRTY_LOG_CONTEXT_EMPTY     -15
+#define SVRTY_LOG_FILE_ERR          -16
+
+#define SVRTY_BATCH_MIN_SIZE        2
+
+#define SVRTY_IOV_LINES             64  // Lines gathered before every write (writev/io_uring backends).
+#define SVRTY_IOV_PER_LINE          10  // Color, time, level, sampling, exe file name, TID, context, payload, color reset, CRLF.
+#define SVRTY_IOV_PAYLOAD_IDX       7
+#define SVRTY_RECORD_SEGMENTS       7   // Time, level, sampling, exe file name, TID, context, payload.
+#define SVRTY_URING_BUFFER_AMOUNT   16
+#define SVRTY_URING_BUFFER_SIZE     (64 * 1024)
+#define SVRTY_PERCPU_SEGMENT_SIZE   (256 * 1024)
 
 #define SVRTY_EXE_FILE_STACK_SIZE       4
 #define SVRTY_EXE_FILE_STACK_LVL        3
@@ -70,6 +105,17 @@
 
 #define SVRTY_TID_FORMAT    "[%#lx] "
 
+#define SVRTY_CONTEXT_MAX_DEPTH     16
+#define SVRTY_CONTEXT_FIRST_FORMAT  "[%s=%s] "
+#define SVRTY_CONTEXT_NEXT_FORMAT   " %s=%s] "
+#define SVRTY_CONTEXT_OPEN_LEN      1   // "["
+#define SVRTY_CONTEXT_CLOSE         "] "
+#define SVRTY_CONTEXT_CLOSE_LEN     2
+
+#define SVRTY_LVL_AMOUNT            4
+#define SVRTY_SAMPLING_FORMAT       "[1/%" PRIu32 "] "
+#define SVRTY_SAMPLING_DISABLED     1
+
 #define SVRTY_SET_MASK_LEVEL_MASK       0b11110000
 #define SVRTY_SET_MASK_TIME_MASK        0b00001000
 #define SVRTY_SET_MASK_FILE_NAME_MASK   0b00000100
@@ -86,28 +132,74 @@
 
 #define SVRTY_CLEAN_STR(str)    memset(str, 0, strlen(str))
 
+#define SVRTY_NS_PER_SEC    1000000000ULL
+
+// Settings may be changed while other threads log. Each one of them is read on its own, so relaxed ordering is enough.
+#define SVRTY_CONFIG_LOAD(VAR_NAME)         __atomic_load_n(&(VAR_NAME), __ATOMIC_RELAXED)
+#define SVRTY_CONFIG_STORE(VAR_NAME, VALUE) __atomic_store_n(&(VAR_NAME), (VALUE), __ATOMIC_RELAXED)
+
 /***********************************/
 
+/**********************************/
+/******** Type definitions ********/
+/**********************************/
+
+/// @brief Tokenized log to be rendered into a per-CPU staging segment.
+typedef struct
+{
+    const char* buffer      ;   // Tokenized buffer.
+    size_t      buffer_len  ;   // Target buffer length (required because of tokenization).
+} SVRTY_LOG_STAGED;
+
+/**********************************/
+
 /***********************************/
 /******** Private variables ********/
 /***********************************/
 
 static          bool    is_initialized                          = false                         ;
+static          bool    is_loaded                               = false                         ;
 static          bool    resources_freed                         = false                         ;
+static          bool    fork_locked                             = false                         ;
+static pthread_once_t   load_once                               = PTHREAD_ONCE_INIT             ;
+static pthread_key_t    log_str_buffer_key                      = {0}                           ;
 static __thread char    severity_color_str[SVRTY_CLR_STR_SIZE]  = {0}                           ;
 static __thread char    time_date_str[SVRTY_TIME_DATE_STR_SIZE] = {0}                           ;
 static __thread char    severity_level_str[SVRTY_LVL_STR_SIZE]  = {0}                           ;
 static __thread char    file_name_str[SVRTY_FILE_NAME_STR_SIZE] = {0}                           ;
 static __thread char    logging_TID[SVRTY_LOGGING_TID]          = {0}                           ;
-static          char*   log_str_buffer                          = NULL                          ;
+static __thread char    sampling_str[SVRTY_SAMPLING_STR_SIZE]   = {0}                           ;
+static __thread char    context_str[SVRTY_CONTEXT_STR_SIZE]     = {0}                           ;
+static __thread size_t  context_str_len                         = 0                             ;
+static __thread size_t  context_lens[SVRTY_CONTEXT_MAX_DEPTH]   = {0}                           ;
+static __thread int     context_depth                           = 0                             ;
+static __thread uint32_t sampling_rng_state                     = 0                             ;
+static __thread char*   log_str_buffer                          = NULL                          ;
+static __thread size_t  log_str_buffer_size                     = 0                             ;
 static          MTX_GRD log_buff_mtx                            = {0}                           ;
-static          int     log_str_payload_size                    = SVRTY_LOG_STR_DEFAULT_SIZE + 1;
+static          size_t  log_str_payload_size                    = SVRTY_LOG_STR_DEFAULT_SIZE    ;
 static          int     severity_log_mask                       = SVRTY_LOG_MASK_EIW            ;
 static          bool    print_time_status                       = false                         ;
 static          bool    print_exe_file_name                     = false                         ;
 static          bool    log_to_syslog                           = false                         ;
+static          bool    syslog_opened                           = false                         ;
+static          uint8_t output_backend                          = SVRTY_LOG_BACKEND_STDIO       ;
+static          bool    print_to_stdout                         = true                          ;
+static          uint8_t overflow_policy                         = SVRTY_LOG_OVERFLOW_BLOCK      ;
+static          bool    err_sync_flush                          = false                         ;
+static          uint32_t file_index_records                     = 0                             ;
+static          uint32_t file_index_bytes                       = 0                             ;
+static SVRTY_LOG_CAPTURE_CALLBACK capture_callback              = NULL                          ;
+static          void*   capture_user_data                       = NULL                          ;
+static          char*   capture_line                            = NULL                          ;   // Captured line, rendered under the output mutex.
+static          size_t  capture_line_size                       = 0                             ;
 static          bool    log_TID                                 = false                         ;
 static          bool    ignore_leading_lib_nums                 = true                          ;
+static          uint64_t span_threshold_ns                      = 0                             ;
+static          uint32_t sampling_rates[SVRTY_LVL_AMOUNT]       = { SVRTY_SAMPLING_DISABLED,
+                                                                    SVRTY_SAMPLING_DISABLED,
+                                                                    SVRTY_SAMPLING_DISABLED,
+                                                                    SVRTY_SAMPLING_DISABLED}    ;
 
 /***********************************/
 
@@ -115,10 +207,17 @@ static          bool    ignore_leading_lib_nums                 = true
 /**** Private function prototypes ****/
 /*************************************/
 
-__attribute__((constructor)) static void SeverityLogLoad(void);
+static void SeverityLogLoad(void);
+static void SeverityLogLazyLoad(void);
 __attribute__((destructor)) static void SeverityLogUnload(void);
-
-static void SeverityLogCleanup(void);
+static void SeverityLogInitMutex(void);
+static void SeverityLogAtForkPrepare(void);
+static void SeverityLogAtForkParent(void);
+static void SeverityLogAtForkChild(void);
+static void SeverityLogFreeThreadBuffer(void* buffer);
+static int  SeverityLogReserveThreadBuffer(void);
+
+static void SeverityLogCleanup(const bool from_signal_handler);
 static void SeverityLogHandleSignal(const int signal_number);
 
 static void ChangeSeverityColor(const int severity);
@@ -127,9 +226,26 @@ static void PrintSeverityLevel(const int severity);
 static void PrintTime(void);
 static void PrintCallingExeFileName(void);
 static int  SeverityLogGetSyslogMsgType(const int severity);
-static void SeverityLogSyslog(const int severity, const size_t buffer_len);
+static void SeverityLogSyslog(const int severity, const char* buffer, const size_t buffer_len);
+static void SeverityLogShmLines(const int severity, const char* buffer, const size_t buffer_len);
+static void SeverityLogCaptureLine(const int severity, const struct iovec* segments, const int segment_amount);
+static void SeverityLogRecordLines(const int severity, const char* buffer, const size_t buffer_len);
 static int  CheckSeverityLogMask(const int severity);
-static void SeverityLogTokenizeCRLF();
+static void SeverityLogTokenizeCRLF(char* buffer, const size_t buffer_len);
+static void SeverityLogPrintLines(const char* buffer, const size_t buffer_len);
+static void SeverityLogWriteLines(const char* buffer, const size_t buffer_len);
+static void SeverityLogWriteIovecs(struct iovec* iov, int iovcnt);
+static size_t SeverityLogRenderLines(char* destination, const char* buffer, const size_t buffer_len);
+static void SeverityLogRenderStaged(char* destination, const void* context);
+static int  SeverityLogStage(const int severity, const char* buffer, const size_t buffer_len);
+static void SeverityLogPerCpuOutput(struct iovec* iov, int iovcnt);
+static void SeverityLogErrSyncFlush(const int severity);
+static int  SeverityLogCheck(const int severity);
+static inline __attribute__((always_inline)) void SeverityLogPreparePrefix(const int severity);
+static uint64_t SeverityLogGetMonotonicNs(void);
+static uint32_t SeverityLogSamplingRand(void);
+static int  CheckSeverityLogSampling(const int severity);
+static void PrintSamplingRate(const int severity);
 
 /*************************************/
 
@@ -138,12 +254,49 @@ static void SeverityLogTokenizeCRLF();
 /*************************************/
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
-/// @brief Function to be called when current library is loaded. Sets up common signal handler.
-/////////////////////////////////////////////////////////////////////////////////////////////// 
-__attribute__((constructor)) static void SeverityLogLoad(void)
+/// @brief Sets up library resources (mutex, common signal handler, fork handlers, buffer key).
+/// Deferred until the library is first used, so that processes not logging do not pay for it.
+///////////////////////////////////////////////////////////////////////////////////////////////
+static void SeverityLogLoad(void)
 {
     resources_freed = false;
 
+    SeverityLogInitMutex();
+
+    pthread_key_create(&log_str_buffer_key, SeverityLogFreeThreadBuffer);
+
+    pthread_atfork(SeverityLogAtForkPrepare, SeverityLogAtForkParent, SeverityLogAtForkChild);
+
+    SignalHandlerAddCallback(SeverityLogHandleSignal, SIG_HDL_ALL_SIGNALS_MASK);
+
+    SVRTY_CONFIG_STORE(is_loaded, true);
+}
+
+///////////////////////////////////////////////////////////////////
+/// @brief Loads library resources once, no matter how many threads
+/// call it at the same time.
+///////////////////////////////////////////////////////////////////
+static void SeverityLogLazyLoad(void)
+{
+    pthread_once(&load_once, SeverityLogLoad);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Function to be called when current library is loaded. Performs resources cleanup.
+////////////////////////////////////////////////////////////////////////////////////////////
+__attribute__((destructor)) static void SeverityLogUnload(void)
+{
+    if(!is_loaded)
+        return;
+
+    SeverityLogCleanup(false);
+}
+
+///////////////////////////////////////////////
+/// @brief Initializes log buffer output mutex.
+///////////////////////////////////////////////
+static void SeverityLogInitMutex(void)
+{
     MTX_GRD_ATTR_INIT_SC(   &log_buff_mtx           ,
                             PTHREAD_MUTEX_RECURSIVE ,
                             PTHREAD_PRIO_INHERIT    ,
@@ -151,43 +304,176 @@ __attribute__((constructor)) static void SeverityLogLoad(void)
                             p_log_buff_mtx_attr     );
 
     MTX_GRD_INIT(&log_buff_mtx);
+}
 
-    SignalHandlerAddCallback(SeverityLogHandleSignal, SIG_HDL_ALL_SIGNALS_MASK);
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Called before fork. Takes every library mutex, so that no log is half-written and
+/// the child does not inherit any of them held by a thread that does not exist there. They
+/// are taken in the order threads nest them: per-CPU staging control (held while waiting for
+/// the writer thread, which takes the output mutex), per-CPU writer (never held while taking
+/// any other lock), output, file sink and io_uring mutexes (taken while printing).
+/////////////////////////////////////////////////////////////////////////////////////////////
+static void SeverityLogAtForkPrepare(void)
+{
+    if(SVRTY_CONFIG_LOAD(resources_freed))
+        return;
+
+    SeverityLogPerCpuLock();
+    MTX_GRD_LOCK(&log_buff_mtx);
+    SeverityLogFileLock();
+    SeverityLogUringLock();
+
+    // Checked after fork rather than resources_freed, which cleanup may set meanwhile.
+    fork_locked = true;
 }
 
-////////////////////////////////////////////////////////////////////////////////////////////
-/// @brief Function to be called when current library is loaded. Performs resources cleanup.
-////////////////////////////////////////////////////////////////////////////////////////////
-__attribute__((destructor)) static void SeverityLogUnload(void)
+///////////////////////////////////////////////////
+/// @brief Called in the parent process after fork.
+///////////////////////////////////////////////////
+static void SeverityLogAtForkParent(void)
 {
-    SeverityLogCleanup();
+    if(!fork_locked)
+        return;
+
+    fork_locked = false;
+
+    SeverityLogUringUnlock();
+    SeverityLogFileUnlock();
+    MTX_GRD_UNLOCK(&log_buff_mtx);
+    SeverityLogPerCpuUnlock();
 }
 
-/////////////////////////////////////////////////////////////////////////////
-/// @brief Performs resources cleanup for current library (frees log buffer).
-/////////////////////////////////////////////////////////////////////////////
-static void SeverityLogCleanup(void)
+//////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Called in the child process after fork. Mutexes are released by the thread that
+/// took them (the only one in the child), but the output mutex, which records its owner's
+/// TID (a different one in the child), is re-created instead. Then parent's threads'
+/// resources are let go of, as they do not exist in the child.
+//////////////////////////////////////////////////////////////////////////////////////////
+static void SeverityLogAtForkChild(void)
 {
-    if(resources_freed)
+    if(!fork_locked)
         return;
-    
-    resources_freed = true;
+
+    fork_locked = false;
+
+    SeverityLogUringUnlock();
+    SeverityLogFileUnlock();
+    SeverityLogInitMutex();
+    SeverityLogPerCpuUnlock();
+
+    // Parent's io_uring instance (and its in-flight buffers) must not be used by the child.
+    if(output_backend == SVRTY_LOG_BACKEND_IO_URING)
+    {
+        SeverityLogUringRelease();
+        output_backend = SVRTY_LOG_BACKEND_WRITEV;
+    }
+
+    SeverityLogShmAtForkChild();
+
+    // Same goes for the file writer thread. Child does not write into parent's file.
+    SeverityLogFileRelease();
+
+    // Writer thread does not exist in the child, so it logs synchronously.
+    SeverityLogPerCpuRelease();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Frees a thread's log buffer once the thread exits. Other keys' destructors may still
+/// log afterwards, so the buffer is forgotten too and allocated again if that happens.
+/// @param buffer Target buffer.
+///////////////////////////////////////////////////////////////////////////////////////////////
+static void SeverityLogFreeThreadBuffer(void* buffer)
+{
+    free(buffer);
+
+    log_str_buffer      = NULL;
+    log_str_buffer_size = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Makes sure calling thread's log buffer exists and matches the payload size.
+/// Buffers are allocated on first use, and resized lazily after SetSeverityLogBufferSize.
+/// @return 0 if allocation was successful, < 0 otherwise.
+//////////////////////////////////////////////////////////////////////////////////////////
+static int SeverityLogReserveThreadBuffer(void)
+{
+    size_t target_size = SVRTY_CONFIG_LOAD(log_str_payload_size) + 1;
+
+    if(log_str_buffer != NULL && log_str_buffer_size == target_size)
+        return SVRTY_LOG_SUCCESS;
+
+    char* new_buffer = (char*)realloc(log_str_buffer, target_size * sizeof(char));
+
+    if(new_buffer == NULL)
+        return SVRTY_LOG_ALLOCATION_ERR;
+
+    new_buffer[0] = SVRTY_STR_END;
+
+    log_str_buffer      = new_buffer;
+    log_str_buffer_size = target_size;
+
+    pthread_setspecific(log_str_buffer_key, log_str_buffer);
+
+    return SVRTY_LOG_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Performs resources cleanup for current library (frees log buffer). Threads
+/// still logging are not waited for: logs are refused from then on, and the ones
+/// already past that check are printed to stdout (other sinks are closed by then).
+/// @param from_signal_handler Called from a signal handler (T/F). If so, logs are only
+/// refused: the interrupted thread may be staging a log or holding a sink's lock, so
+/// writer threads are neither joined nor waited for, and nothing is freed. That is left
+/// to the destructor, if the process survives the signal.
+////////////////////////////////////////////////////////////////////////////////////////
+static void SeverityLogCleanup(const bool from_signal_handler)
+{
+    if(from_signal_handler)
+    {
+        SVRTY_CONFIG_STORE(is_initialized, false);
+        return;
+    }
+
+    // Only the first caller cleans up.
+    if(__atomic_exchange_n(&resources_freed, true, __ATOMIC_ACQ_REL))
+        return;
+
+    // Writer thread needs the output mutex to print what is still staged.
+    SeverityLogPerCpuExit();
 
     MTX_GRD_LOCK(&log_buff_mtx);
 
     SVRTY_LOG_DBG(SVRTY_MSG_CLEANUP);
 
-    if(log_to_syslog)
+    SVRTY_CONFIG_STORE(is_initialized, false);
+
+    if(syslog_opened)
+    {
         closelog();
+        syslog_opened = false;
+    }
+
+    SeverityLogUringExit();
+
+    SeverityLogShmClose();
+
+    SeverityLogFileClose();
 
+    free(capture_line);
+    capture_line        = NULL;
+    capture_line_size   = 0;
+
+    // Only calling thread's buffer can be freed here, the rest are freed as their threads exit.
     if(log_str_buffer)
     {
+        pthread_setspecific(log_str_buffer_key, NULL);
         free(log_str_buffer);
         log_str_buffer = NULL;
+        log_str_buffer_size = 0;
     }
 
+    // Mutex is not destroyed, as threads already past the initialization check may still take it.
     MTX_GRD_UNLOCK(&log_buff_mtx);
-    MTX_GRD_DESTROY(&log_buff_mtx);
 }
 
 ////////////////////////////////////////////////////////////
@@ -196,7 +482,7 @@ static void SeverityLogCleanup(void)
 ////////////////////////////////////////////////////////////
 static void SeverityLogHandleSignal(const int signal_number)
 {
-    SeverityLogCleanup();
+    SeverityLogCleanup(true);
 }
 
 /////////////////////////////////////////////////////////////
@@ -264,29 +550,25 @@ static void PrintSeverityLevel(const int severity)
                 severity_level_string_ptr   );
 }
 
-//////////////////////////////////////////////////////////////////////////////////////
-/// @brief Sets severity log buffer payload size.
+/////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Sets severity log buffer payload size. Each thread's buffer is allocated
+/// (or resized) the next time it logs, except for calling thread's if it already exists.
 /// @param buffer_size Target payload size (a trailing zero is used to ensure safety).
 /// @return 0 if allocation was successful, < 0 otherwise.
-//////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
 int SetSeverityLogBufferSize(size_t buffer_size)
 {
-    MTX_GRD_LOCK_SC(&log_buff_mtx, p_log_buff_mtx);
+    SeverityLogLazyLoad();
 
     if(buffer_size <= 0)
         buffer_size = SVRTY_LOG_STR_DEFAULT_SIZE;
 
-    log_str_payload_size = buffer_size;
-
-    if(log_str_buffer == NULL)
-        log_str_buffer = (char*)calloc(buffer_size + 1, sizeof(char));
-    else
-        log_str_buffer = (char*)realloc(log_str_buffer, (buffer_size + 1) * sizeof(char));
+    SVRTY_CONFIG_STORE(log_str_payload_size, buffer_size);
 
     if(log_str_buffer == NULL)
-            return SVRTY_LOG_ALLOCATION_ERR;
+        return SVRTY_LOG_SUCCESS;
 
-    return SVRTY_LOG_SUCCESS;
+    return SeverityLogReserveThreadBuffer();
 }
 
 /////////////////////////////////////////////////////
@@ -295,7 +577,7 @@ int SetSeverityLogBufferSize(size_t buffer_size)
 /////////////////////////////////////////////////////
 void SetSeverityLogMask(const uint8_t mask)
 {
-    severity_log_mask = mask;
+    SVRTY_CONFIG_STORE(severity_log_mask, mask);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -305,20 +587,104 @@ void SetSeverityLogMask(const uint8_t mask)
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 static int CheckSeverityLogMask(const int severity)
 {
+    // Unknown levels have no bit within the mask (shifting by a negative amount is not even defined).
+    if(severity < SVRTY_LVL_ERR || severity > SVRTY_LVL_DBG)
+        return SVRTY_LOG_WNG_SILENT_LVL;
+
     int bit_to_check = (1 << (severity - 1));
-    if( (severity_log_mask & bit_to_check) != 0)
+    if( (SVRTY_CONFIG_LOAD(severity_log_mask) & bit_to_check) != 0)
         return SVRTY_LOG_SUCCESS;
 
     return SVRTY_LOG_WNG_SILENT_LVL;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////
+/// @brief Sets the sampling rate for a given severity level (1 out of N logs is kept).
+/// @param severity Target severity level.
+/// @param rate Target sampling rate (0 or 1 disable sampling).
+/// @return 0 if succeeded, < 0 if an invalid severity level was provided.
+///////////////////////////////////////////////////////////////////////////////////////
+int SetSeverityLogSamplingRate(const uint8_t severity, const uint32_t rate)
+{
+    if(severity < SVRTY_LVL_ERR || severity > SVRTY_LVL_DBG)
+        return SVRTY_LOG_INVALID_LVL;
+
+    SVRTY_CONFIG_STORE(sampling_rates[severity - 1], (rate == 0 ? SVRTY_SAMPLING_DISABLED : rate));
+
+    return SVRTY_LOG_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////
+/// @brief Per-thread xorshift32 generator. Seeded lazily on first use.
+/// @return Next pseudo-random number of the calling thread's sequence.
+///////////////////////////////////////////////////////////////////////
+static uint32_t SeverityLogSamplingRand(void)
+{
+    uint32_t x = sampling_rng_state;
+
+    // State must never be zero, otherwise the sequence gets stuck.
+    if(x == 0)
+        x = (uint32_t)((uintptr_t)pthread_self() ^ SeverityLogGetMonotonicNs()) | 1;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    sampling_rng_state = x;
+
+    return x;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Decides whether or not a log should be kept according to its level's sampling rate.
+/// @param severity Target message severity level.
+/// @return SVRTY_LOG_SUCCESS if the log is kept, SVRTY_LOG_WNG_SAMPLED_OUT otherwise.
+//////////////////////////////////////////////////////////////////////////////////////////////
+static int CheckSeverityLogSampling(const int severity)
+{
+    if(severity < SVRTY_LVL_ERR || severity > SVRTY_LVL_DBG)
+        return SVRTY_LOG_SUCCESS;
+
+    uint32_t rate = SVRTY_CONFIG_LOAD(sampling_rates[severity - 1]);
+
+    if(rate <= SVRTY_SAMPLING_DISABLED)
+        return SVRTY_LOG_SUCCESS;
+
+    if( (SeverityLogSamplingRand() % rate) == 0)
+        return SVRTY_LOG_SUCCESS;
+
+    return SVRTY_LOG_WNG_SAMPLED_OUT;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Writes the sampling rate of sampled levels so that counts can be re-weighted.
+/// @param severity Severity level (ERR, INF, WNG, DBG)
+////////////////////////////////////////////////////////////////////////////////////////
+static void PrintSamplingRate(const int severity)
+{
+    SVRTY_CLEAN_STR(sampling_str);
+
+    if(severity < SVRTY_LVL_ERR || severity > SVRTY_LVL_DBG)
+        return;
+
+    uint32_t rate = SVRTY_CONFIG_LOAD(sampling_rates[severity - 1]);
+
+    if(rate <= SVRTY_SAMPLING_DISABLED)
+        return;
+
+    snprintf(   sampling_str            ,
+                sizeof(sampling_str)    ,
+                SVRTY_SAMPLING_FORMAT   ,
+                rate                    );
+}
+
 ///////////////////////////////////////////////////////////
 /// @brief Set value of print_time_status private variable.
 /// @param time_status Target status value (T/F).
 ///////////////////////////////////////////////////////////
 void SetSeverityLogPrintTimeStatus(const bool time_status)
 {
-    print_time_status = time_status;
+    SVRTY_CONFIG_STORE(print_time_status, time_status);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////// 
@@ -326,20 +692,20 @@ void SetSeverityLogPrintTimeStatus(const bool time_status)
 //////////////////////////////////////////////////////////////////////////////////////////
 static void PrintTime(void)
 {
-    if(!print_time_status)
+    if(!SVRTY_CONFIG_LOAD(print_time_status))
         return;
 
     time_t current_time;
-    struct tm* time_info;
+    struct tm time_info;
 
     time(&current_time);  // Get the current time
-    time_info = localtime(&current_time);  // Convert to local time
 
-    if (time_info == NULL)
+    // Convert to local time. Reentrant version is used, as localtime's result is shared among threads.
+    if (localtime_r(&current_time, &time_info) == NULL)
         return;
 
     char time_str[SVRTY_TIME_DATE_SIZE];
-    strftime(time_str, sizeof(time_str), SVRTY_TIME_DATE_FORMAT, time_info);
+    strftime(time_str, sizeof(time_str), SVRTY_TIME_DATE_FORMAT, &time_info);
     
     SVRTY_CLEAN_STR(time_date_str);
 
@@ -355,7 +721,7 @@ static void PrintTime(void)
 /////////////////////////////////////////////////////////////
 void SetSeverityLogPrintExeNameStatus(const bool exe_name_status)
 {
-    print_exe_file_name = exe_name_status;
+    SVRTY_CONFIG_STORE(print_exe_file_name, exe_name_status);
 }
 
 /////////////////////////////////////////////////////
@@ -364,7 +730,7 @@ void SetSeverityLogPrintExeNameStatus(const bool exe_name_status)
 /////////////////////////////////////////////////////
 void SetSeverityLogPrintTID(const bool print_TID_status)
 {
-    log_TID = print_TID_status;
+    SVRTY_CONFIG_STORE(log_TID, print_TID_status);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
@@ -373,12 +739,18 @@ void SetSeverityLogPrintTID(const bool print_TID_status)
 ////////////////////////////////////////////////////////////////////////////////////////////////
 void SetSeverityLogSyslogStatus(const bool log_to_syslog_status)
 {
-    if(log_to_syslog_status)
-        openlog(NULL, LOG_PID, LOG_USER);
-    else
+    SeverityLogLazyLoad();
+
+    MTX_GRD_LOCK_SC(&log_buff_mtx, p_log_buff_mtx);
+
+    // Syslog is opened by the first record sent to it.
+    if(!log_to_syslog_status && syslog_opened)
+    {
         closelog();
+        syslog_opened = false;
+    }
 
-    log_to_syslog = log_to_syslog_status;
+    SVRTY_CONFIG_STORE(log_to_syslog, log_to_syslog_status);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////// 
@@ -386,7 +758,7 @@ void SetSeverityLogSyslogStatus(const bool log_to_syslog_status)
 /////////////////////////////////////////////////////////////////////////////////////
 static void PrintCallingExeFileName(void)
 {
-    if(!print_exe_file_name)
+    if(!SVRTY_CONFIG_LOAD(print_exe_file_name))
         return;
 
     void *buffer[SVRTY_EXE_FILE_STACK_SIZE];
@@ -417,7 +789,7 @@ static void PrintCallingExeFileName(void)
         }
 
         // Remove leading numbers if needed. Although exotic, it may be required if leading numbers were used to specify linking order.
-        if(ignore_leading_lib_nums)
+        if(SVRTY_CONFIG_LOAD(ignore_leading_lib_nums))
             while(*file_name >= '0' && *file_name <= '9')
                 ++file_name;
 
@@ -435,7 +807,7 @@ static void PrintCallingExeFileName(void)
 
 static void PrintTID(void)
 {
-    if(!log_TID)
+    if(!SVRTY_CONFIG_LOAD(log_TID))
         return;
 
     SVRTY_CLEAN_STR(logging_TID);
@@ -480,9 +852,10 @@ static int SeverityLogGetSyslogMsgType(const int severity)
 //////////////////////////////////////////////////////////////////////////////
 /// @brief Logs to syslog or journal (using syslog funcitons).
 /// @param severity Severity level.
+/// @param buffer Tokenized buffer.
 /// @param buffer_len Target buffer length (required because of tokenization).
 //////////////////////////////////////////////////////////////////////////////
-static void SeverityLogSyslog(const int severity, const size_t buffer_len)
+static void SeverityLogSyslog(const int severity, const char* buffer, const size_t buffer_len)
 {
     if(!log_to_syslog)
         return;
@@ -492,18 +865,26 @@ static void SeverityLogSyslog(const int severity, const size_t buffer_len)
     if(syslog_msg_type < 0)
         return;
 
-    char *ptr   = log_str_buffer;
-    char *end   = log_str_buffer + buffer_len;
+    if(!syslog_opened)
+    {
+        openlog(NULL, LOG_PID, LOG_USER);
+        syslog_opened = true;
+    }
+
+    const char *ptr = buffer;
+    const char *end = buffer + buffer_len;
 
     while (ptr < end)
     {
         if (*ptr != SVRTY_STR_END)
         {
             syslog( syslog_msg_type     ,
-                    "%s%s%s%s"          ,
+                    "%s%s%s%s%s%s"      ,
                     severity_level_str  ,
+                    sampling_str        ,
                     file_name_str       ,
                     logging_TID         ,
+                    context_str         ,
                     ptr                 );
             ptr += (strlen(ptr) + 1);
         }
@@ -514,174 +895,579 @@ static void SeverityLogSyslog(const int severity, const size_t buffer_len)
     }
 }
 
-/////////////////////////////////////////////////////////////////////
-/// @brief Inits severity Log functionality by using a settings mask.
-/// @param buffer_size Target buffer payload size.
-/// @param init_mask Mask including the following fields:
-///  0b11110000 -> Severity level mask.
-///  0b00001000 -> Print time bit.
-///  0b00000100 -> Print calling exe file name bit.
-///  0b00000010 -> Print calling thread's TID bit.
-///  0b00000001 -> Log to syslog bit.
-/// @return 0 if succeeded, < 0 otherwise.
-/////////////////////////////////////////////////////////////////////
-int SeverityLogInitWithMask(const size_t buffer_size, const uint8_t init_mask)
-{
-    return SeverityLogInit( buffer_size,
-                            (const uint8_t) (SVRTY_GET_MASK_FIELD(init_mask, LEVEL))    ,
-                            (const bool)    (SVRTY_GET_MASK_FIELD(init_mask, TIME))     ,
-                            (const bool)    (SVRTY_GET_MASK_FIELD(init_mask, FILE_NAME)),
-                            (const bool)    (SVRTY_GET_MASK_FIELD(init_mask, TID))      ,
-                            (const bool)    (SVRTY_GET_MASK_FIELD(init_mask, SYSLOG))   );
-}
-
-/////////////////////////////////////////////////////////////
-/// @brief Inits severity Log functionality.
-/// @param buffer_size Target buffer payload size.
-/// @param severity_level_mask Target severity level(s) mask.
-/// @param print_time Print log's time and date (T/F).
-/// @param print_exe_file Print logging file's name (T/F).
-/// @param print_TID Print logging thread's TID (T/F).
-/// @param log_to_syslog Log to syslog/journal file (T/F).
-/// @return 0 if succeeded, < 0 otherwise.
-/////////////////////////////////////////////////////////////
-int SeverityLogInit(const size_t buffer_size            ,
-                    const uint8_t severity_level_mask   ,
-                    const bool print_time               ,
-                    const bool print_exe_file           ,
-                    const bool print_TID                ,
-                    const bool log_to_syslog            )
+//////////////////////////////////////////////////////////////////////////////
+/// @brief Publishes every line into the shared memory ring (if attached).
+/// @param severity Severity level.
+/// @param buffer Tokenized buffer.
+/// @param buffer_len Target buffer length (required because of tokenization).
+//////////////////////////////////////////////////////////////////////////////
+static void SeverityLogShmLines(const int severity, const char* buffer, const size_t buffer_len)
 {
-    int set_buffer_size = SetSeverityLogBufferSize(buffer_size);
-    
-    if(set_buffer_size < 0)
-        return set_buffer_size;
-    
-    SetSeverityLogMask(severity_level_mask);
-    SetSeverityLogPrintTimeStatus(print_time);
-    SetSeverityLogPrintExeNameStatus(print_exe_file);
-    SetSeverityLogSyslogStatus(log_to_syslog);
-    SetSeverityLogPrintTID(print_TID);
-
-    SVRTY_LOG_DBG(SVRTY_MSG_INIT);
-
-    is_initialized = true;
+    if(!SeverityLogShmIsOpen())
+        return;
 
-    return SVRTY_LOG_SUCCESS;
-}
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// @brief Tells whether names used to order libraries should be ignored or not when printing calling file name.
-/// @param ignore_lead_nums Ignore library name's leading numbers (after "lib").
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-void SeverityLogIgnoreLeadLibNameNums(bool ignore_lead_nums)
-{
-    ignore_leading_lib_nums = ignore_lead_nums;
-}
+    uint64_t timestamp_ns = ((uint64_t)now.tv_sec * SVRTY_NS_PER_SEC) + (uint64_t)now.tv_nsec;
 
-///////////////////////////////////////////////////////////////////////
-/// @brief Tokenizes log buffer using "\n" and/or "\r\n" as delimiters.
-///////////////////////////////////////////////////////////////////////
-static void SeverityLogTokenizeCRLF(void)
-{
-    size_t cur_log_str_buffer_len = strlen(log_str_buffer);
-    size_t i = 0;
+    // Context is published as bare fields ("key=value ..."), without the surrounding brackets.
+    const char* context_fields  = (context_str_len > 0 ? context_str + SVRTY_CONTEXT_OPEN_LEN : context_str);
+    size_t context_fields_len   = (context_str_len > 0 ? context_str_len - SVRTY_CONTEXT_OPEN_LEN - SVRTY_CONTEXT_CLOSE_LEN : 0);
 
-    MTX_GRD_LOCK_SC(&log_buff_mtx, p_log_buff_mtx);
+    const char *ptr = buffer;
+    const char *end = buffer + buffer_len;
 
-    // Replace "\r\n" or "\n" with "\0" or "\0\0" respectively.
-    while (i < cur_log_str_buffer_len)
+    while (ptr < end)
     {
-        if (log_str_buffer[i] == SVRTY_CR && log_str_buffer[i + 1] == SVRTY_LF)
-        {
-            log_str_buffer[i] = SVRTY_STR_END;
-            log_str_buffer[i + 1] = SVRTY_STR_END;
-            i += 2;
-        }
-        else if (log_str_buffer[i] == SVRTY_LF)
+        if (*ptr != SVRTY_STR_END)
         {
-            log_str_buffer[i] = SVRTY_STR_END;
-            i++;
+            size_t ptr_len = strlen(ptr);
+            SeverityLogShmPublish((uint8_t)severity, timestamp_ns, context_fields, context_fields_len, ptr, ptr_len);
+            ptr += (ptr_len + 1);
         }
         else
         {
-            i++;
+            ++ptr;
         }
     }
 }
 
-//////////////////////////////////////////////////////////////////////////////////////////////////
-/// @brief Prints a log with different color and initial string depending on the severity level.
-/// @param severity Severity level (ERR, INF, WNG).
-/// @param format Formatted string. Same as what can be used with printf.
-/// @param ... Variable number of arguments. Data that is meant to be formatted and printed.
-/// @return < 0 if any error happened, number of characters written to stream otherwise.
-//////////////////////////////////////////////////////////////////////////////////////////////////
-int SeverityLog(const uint8_t severity, const char* C_SEVERITY_LOG_RESTRICT format, ...)
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Publishes logs into a named shared memory ring, from which a collector process
+/// can consume them (see SeverityLogShm_api.h). If the ring already exists, it is attached
+/// to as it is, so several processes can share it.
+/// @param name Shared memory object name (i.e. "/my_log"). NULL detaches from the ring.
+/// @param slot_amount Number of slots (rounded up to a power of two).
+/// @param slot_size Size of each slot, 32 byte record header included (rounded up to a multiple of 64).
+/// @return 0 if succeeded, < 0 otherwise.
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+int SetSeverityLogShmSink(const char* name, const uint32_t slot_amount, const uint32_t slot_size)
 {
-    if(!is_initialized)
-        return SVRTY_LOG_UNINITIALIZED;
+    SeverityLogLazyLoad();
 
-    if(log_str_buffer == NULL)
-    {
-        int init_log_buffer = SetSeverityLogBufferSize(log_str_payload_size);
+    MTX_GRD_LOCK_SC(&log_buff_mtx, p_log_buff_mtx);
 
-        if(init_log_buffer < 0)
-            return init_log_buffer;
+    if(name == NULL)
+    {
+        SeverityLogShmClose();
+        return SVRTY_LOG_SUCCESS;
     }
 
-    int check_severity_log_mask = CheckSeverityLogMask(severity);
+    return (SeverityLogShmOpen(name, slot_amount, slot_size) < 0 ? SVRTY_LOG_SHM_ERR : SVRTY_LOG_SUCCESS);
+}
 
-    if(check_severity_log_mask < 0)
-        return check_severity_log_mask;
+//////////////////////////////////////////////////////////////////////////
+/// @brief Concatenates a line's segments and hands it over to the capture
+/// callback. Must be called while holding the output mutex.
+/// @param severity Severity level.
+/// @param segments Line segments (prefix and payload).
+/// @param segment_amount Number of segments.
+//////////////////////////////////////////////////////////////////////////
+static void SeverityLogCaptureLine(const int severity, const struct iovec* segments, const int segment_amount)
+{
+    size_t line_len = 0;
 
-    ChangeSeverityColor(severity);
-    PrintTime();
+    for(int i = 0; i < segment_amount; i++)
+        line_len += segments[i].iov_len;
 
-    PrintSeverityLevel(severity);
-    PrintCallingExeFileName();
-    PrintTID();
+    if(line_len + 1 > capture_line_size)
+    {
+        char* new_line = (char*)realloc(capture_line, line_len + 1);
 
-    va_list args;
-    int done;
+        if(new_line == NULL)
+            return;
+
+        capture_line        = new_line;
+        capture_line_size   = line_len + 1;
+    }
+
+    size_t copied = 0;
+
+    for(int i = 0; i < segment_amount; i++)
+    {
+        memcpy(capture_line + copied, segments[i].iov_base, segments[i].iov_len);
+        copied += segments[i].iov_len;
+    }
+
+    capture_line[line_len] = SVRTY_STR_END;
+
+    capture_callback((uint8_t)severity, capture_line, line_len, capture_user_data);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @brief Hands every line over to record based sinks: log file (if open) and
+/// capture callback (if set). Lines are rendered as they are printed to
+/// stdout, without colors. Must be called while holding the output mutex.
+/// @param severity Severity level.
+/// @param buffer Tokenized buffer.
+/// @param buffer_len Target buffer length (required because of tokenization).
+//////////////////////////////////////////////////////////////////////////////
+static void SeverityLogRecordLines(const int severity, const char* buffer, const size_t buffer_len)
+{
+    bool to_file = SeverityLogFileIsOpen();
+
+    if(!to_file && capture_callback == NULL)
+        return;
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    uint64_t timestamp_ns = ((uint64_t)now.tv_sec * SVRTY_NS_PER_SEC) + (uint64_t)now.tv_nsec;
+
+    // Same as staging buffers: only INF and DBG records may be dropped, and only if allowed to.
+    bool droppable = (  severity != SVRTY_LVL_ERR && severity != SVRTY_LVL_WNG   &&
+                        SVRTY_CONFIG_LOAD(overflow_policy) == SVRTY_LOG_OVERFLOW_DROP);
+
+    struct iovec segments[SVRTY_RECORD_SEGMENTS] =
+    {
+        {time_date_str      , strlen(time_date_str)     },
+        {severity_level_str , strlen(severity_level_str)},
+        {sampling_str       , strlen(sampling_str)      },
+        {file_name_str      , strlen(file_name_str)     },
+        {logging_TID        , strlen(logging_TID)       },
+        {context_str        , context_str_len           },
+        {NULL               , 0                         },  // Payload, set for each line.
+    };
+
+    const char *ptr = buffer;
+    const char *end = buffer + buffer_len;
+
+    while (ptr < end)
+    {
+        if (*ptr != SVRTY_STR_END)
+        {
+            size_t ptr_len = strlen(ptr);
+
+            segments[SVRTY_RECORD_SEGMENTS - 1].iov_base  = (void*)ptr;
+            segments[SVRTY_RECORD_SEGMENTS - 1].iov_len   = ptr_len;
+
+            if(to_file)
+                SeverityLogFileAppend((uint8_t)severity, timestamp_ns, segments, SVRTY_RECORD_SEGMENTS, droppable);
+
+            if(capture_callback != NULL)
+                SeverityLogCaptureLine(severity, segments, SVRTY_RECORD_SEGMENTS);
+
+            ptr += (ptr_len + 1);
+        }
+        else
+        {
+            ++ptr;
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Writes logs into a file, in independently compressed blocks followed by a block index,
+/// so that any time range can be read without decompressing the whole file (see
+/// SeverityLogFile_api.h and svrty_cat tool). Blocks are compressed by a writer thread.
+/// @param path File path (truncated if it exists). NULL closes the current file.
+/// @param compression SVRTY_LOG_FILE_COMPRESSION_NONE or SVRTY_LOG_FILE_COMPRESSION_LZ.
+/// @param block_size Maximum block size, before compression (0 sets the default one, 64 KB).
+/// @return 0 if succeeded, < 0 otherwise.
+/////////////////////////////////////////////////////////////////////////////////////////////////
+int SetSeverityLogFileSink(const char* path, const uint8_t compression, const size_t block_size)
+{
+    if(path != NULL && compression != SVRTY_LOG_FILE_COMPRESSION_NONE && compression != SVRTY_LOG_FILE_COMPRESSION_LZ)
+        return SVRTY_LOG_FILE_ERR;
+
+    SeverityLogLazyLoad();
 
-    va_start(args, format);
-    
     MTX_GRD_LOCK_SC(&log_buff_mtx, p_log_buff_mtx);
 
-    done = vsnprintf(   (log_str_buffer + strlen(log_str_buffer))       ,
-                        (log_str_payload_size - strlen(log_str_buffer)) ,
-                        format                                          ,
-                        args                                            );
-    
-    va_end(args);
+    // File writer thread does not need the output mutex, so it can be waited for here.
+    SeverityLogFileClose();
 
-    log_str_buffer[strlen(log_str_buffer)] = SVRTY_STR_END;
+    if(path == NULL)
+        return SVRTY_LOG_SUCCESS;
 
-    size_t cur_log_str_buffer_len = strlen(log_str_buffer);
+    return (SeverityLogFileOpen(path, compression, block_size, file_index_records, file_index_bytes) < 0 ? SVRTY_LOG_FILE_ERR : SVRTY_LOG_SUCCESS);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Makes file sinks write a sparse sidecar index (<path>.idx) alongside the log file, with
+/// an entry (timestamp, block, offset within the block and severity levels found) every given
+/// number of records or bytes. Time range queries (see svrty_query tool) binary search it rather
+/// than scanning the file, even if the file is still being written. Applies to files opened
+/// afterwards (see SetSeverityLogFileSink). Both set to 0 (default) disables it.
+/// @param record_interval Records per index entry, at most (0: no limit).
+/// @param byte_interval Bytes per index entry (before compression), at most (0: no limit).
+//////////////////////////////////////////////////////////////////////////////////////////////////
+void SetSeverityLogFileSidecarIndex(const uint32_t record_interval, const uint32_t byte_interval)
+{
+    SeverityLogLazyLoad();
+
+    MTX_GRD_LOCK_SC(&log_buff_mtx, p_log_buff_mtx);
+
+    file_index_records  = record_interval;
+    file_index_bytes    = byte_interval;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Gets the number of INF and DBG records dropped from the current file sink under
+/// SVRTY_LOG_OVERFLOW_DROP because its writer thread fell too far behind (loggers never
+/// wait for compression or disk I/O).
+/// @return Number of dropped records.
+//////////////////////////////////////////////////////////////////////////////////////////
+uint64_t SeverityLogGetFileDroppedCount(void)
+{
+    return SeverityLogFileDropped();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Hands every line over to a callback, alongside the rest of sinks (meant for tests and
+/// in-process collectors). Callbacks must not log, nor take locks held by logging threads.
+/// @param callback Target callback (see SVRTY_LOG_CAPTURE_CALLBACK). NULL disables capturing.
+/// @param user_data Provided to the callback as it is.
+////////////////////////////////////////////////////////////////////////////////////////////////
+void SetSeverityLogCaptureSink(SVRTY_LOG_CAPTURE_CALLBACK callback, void* user_data)
+{
+    SeverityLogLazyLoad();
+
+    MTX_GRD_LOCK_SC(&log_buff_mtx, p_log_buff_mtx);
+
+    capture_user_data = user_data;
+
+    // Staging path checks it without holding the output mutex.
+    __atomic_store_n(&capture_callback, callback, __ATOMIC_RELAXED);
+}
+
+////////////////////////////////////////////////////////////////////////
+/// @brief Sets whether logs are printed to stdout. Other sinks (syslog,
+/// shared memory ring, file) are not affected.
+/// @param stdout_status Print to stdout (T/F).
+////////////////////////////////////////////////////////////////////////
+void SetSeverityLogStdoutStatus(const bool stdout_status)
+{
+    SVRTY_CONFIG_STORE(print_to_stdout, stdout_status);
+}
+
+/////////////////////////////////////////////////////////////////////
+/// @brief Inits severity Log functionality by using a settings mask.
+/// @param buffer_size Target buffer payload size.
+/// @param init_mask Mask including the following fields:
+///  0b11110000 -> Severity level mask.
+///  0b00001000 -> Print time bit.
+///  0b00000100 -> Print calling exe file name bit.
+///  0b00000010 -> Print calling thread's TID bit.
+///  0b00000001 -> Log to syslog bit.
+/// @return 0 if succeeded, < 0 otherwise.
+/////////////////////////////////////////////////////////////////////
+int SeverityLogInitWithMask(const size_t buffer_size, const uint8_t init_mask)
+{
+    return SeverityLogInit( buffer_size,
+                            (const uint8_t) (SVRTY_GET_MASK_FIELD(init_mask, LEVEL))    ,
+                            (const bool)    (SVRTY_GET_MASK_FIELD(init_mask, TIME))     ,
+                            (const bool)    (SVRTY_GET_MASK_FIELD(init_mask, FILE_NAME)),
+                            (const bool)    (SVRTY_GET_MASK_FIELD(init_mask, TID))      ,
+                            (const bool)    (SVRTY_GET_MASK_FIELD(init_mask, SYSLOG))   );
+}
+
+/////////////////////////////////////////////////////////////
+/// @brief Inits severity Log functionality.
+/// @param buffer_size Target buffer payload size.
+/// @param severity_level_mask Target severity level(s) mask.
+/// @param print_time Print log's time and date (T/F).
+/// @param print_exe_file Print logging file's name (T/F).
+/// @param print_TID Print logging thread's TID (T/F).
+/// @param log_to_syslog Log to syslog/journal file (T/F).
+/// @return 0 if succeeded, < 0 otherwise.
+/////////////////////////////////////////////////////////////
+int SeverityLogInit(const size_t buffer_size            ,
+                    const uint8_t severity_level_mask   ,
+                    const bool print_time               ,
+                    const bool print_exe_file           ,
+                    const bool print_TID                ,
+                    const bool log_to_syslog            )
+{
+    SeverityLogLazyLoad();
+
+    int set_buffer_size = SetSeverityLogBufferSize(buffer_size);
+    
+    if(set_buffer_size < 0)
+        return set_buffer_size;
     
-    SeverityLogTokenizeCRLF();
+    SetSeverityLogMask(severity_level_mask);
+    SetSeverityLogPrintTimeStatus(print_time);
+    SetSeverityLogPrintExeNameStatus(print_exe_file);
+    SetSeverityLogSyslogStatus(log_to_syslog);
+    SetSeverityLogPrintTID(print_TID);
+
+    SVRTY_LOG_DBG(SVRTY_MSG_INIT);
 
-    SeverityLogSyslog(severity, cur_log_str_buffer_len);
+    SVRTY_CONFIG_STORE(is_initialized, true);
 
-    // Iterate over tokens
-    char *ptr   = log_str_buffer;
-    char *end   = log_str_buffer + cur_log_str_buffer_len;
+    return SVRTY_LOG_SUCCESS;
+}
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Tells whether names used to order libraries should be ignored or not when printing calling file name.
+/// @param ignore_lead_nums Ignore library name's leading numbers (after "lib").
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void SeverityLogIgnoreLeadLibNameNums(bool ignore_lead_nums)
+{
+    SVRTY_CONFIG_STORE(ignore_leading_lib_nums, ignore_lead_nums);
+}
+
+/////////////////////////////////////////////////////////////////////
+/// @brief Tokenizes a buffer using "\n" and/or "\r\n" as delimiters.
+/// @param buffer Target buffer.
+/// @param buffer_len Target buffer length.
+/////////////////////////////////////////////////////////////////////
+static void SeverityLogTokenizeCRLF(char* buffer, const size_t buffer_len)
+{
+    size_t i = 0;
+
+    // Replace "\r\n" or "\n" with "\0" or "\0\0" respectively.
+    while (i < buffer_len)
+    {
+        if (buffer[i] == SVRTY_CR && buffer[i + 1] == SVRTY_LF)
+        {
+            buffer[i] = SVRTY_STR_END;
+            buffer[i + 1] = SVRTY_STR_END;
+            i += 2;
+        }
+        else if (buffer[i] == SVRTY_LF)
+        {
+            buffer[i] = SVRTY_STR_END;
+            i++;
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+//////////////////////////////////////////////////
+/// @brief Reads CLOCK_MONOTONIC.
+/// @return Current monotonic time in nanoseconds.
+//////////////////////////////////////////////////
+static uint64_t SeverityLogGetMonotonicNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * SVRTY_NS_PER_SEC) + (uint64_t)now.tv_nsec;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+/// @brief Sets the minimum duration a span must last for it to be logged.
+/// @param threshold_ns Minimum span duration in nanoseconds (0 logs every span).
+/////////////////////////////////////////////////////////////////////////////////
+void SetSeverityLogSpanThreshold(const uint64_t threshold_ns)
+{
+    SVRTY_CONFIG_STORE(span_threshold_ns, threshold_ns);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Tells whether or not a span with the given severity level gets timed.
+/// @param severity Target severity level.
+/// @return true if the library is initialized and the severity level is valid
+/// and not masked.
+////////////////////////////////////////////////////////////////////////////////
+bool SeverityLogSpanEnabled(const uint8_t severity)
+{
+    return (SVRTY_CONFIG_LOAD(is_initialized) && (CheckSeverityLogMask(severity) == SVRTY_LOG_SUCCESS));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Starts a timing span. Time is only sampled if the severity level is not masked.
+/// @param severity Severity level the span will be logged with.
+/// @param name Span name. Must outlive the span itself (string literals are the usual choice).
+/// @return Span to be handed to SeverityLogSpanEnd.
+///////////////////////////////////////////////////////////////////////////////////////////////
+SVRTY_LOG_SPAN SeverityLogSpanBegin(const uint8_t severity, const char* name)
+{
+    SVRTY_LOG_SPAN span = {name, severity, 0};
+
+    if(SeverityLogSpanEnabled(severity))
+        span.start_ns = SeverityLogGetMonotonicNs();
+
+    return span;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Ends a timing span, logging its duration if it exceeds the configured threshold.
+/// @param span Target span, as returned by SeverityLogSpanBegin.
+/// @return < 0 if nothing was logged, number of characters written to stream otherwise.
+///////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogSpanEnd(SVRTY_LOG_SPAN* span)
+{
+    // Disabled spans are never timed, so a single check is enough to leave.
+    if(span->start_ns == 0)
+        return SVRTY_LOG_WNG_SILENT_LVL;
+
+    uint64_t elapsed_ns = SeverityLogGetMonotonicNs() - span->start_ns;
+
+    span->start_ns = 0;
+
+    if(elapsed_ns < SVRTY_CONFIG_LOAD(span_threshold_ns))
+        return SVRTY_LOG_WNG_SHORT_SPAN;
+
+    return SeverityLog(span->severity, SVRTY_MSG_SPAN, span->name, elapsed_ns);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Pushes a key/value pair into calling thread's logging context. Every log printed by
+/// the thread includes its context after the TID. Context is rendered here, rather than
+/// every time a log is printed.
+/// @param key Context key (i.e. "req").
+/// @param value Context value.
+/// @return 0 if succeeded, < 0 if the context is full.
+//////////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogContextPush(const char* key, const char* value)
+{
+    if(context_depth >= SVRTY_CONTEXT_MAX_DEPTH)
+        return SVRTY_LOG_CONTEXT_FULL;
+
+    // New fields are written over the closing bracket, if any.
+    size_t offset       = (context_depth == 0 ? 0 : context_str_len - SVRTY_CONTEXT_CLOSE_LEN);
+    const char* format  = (context_depth == 0 ? SVRTY_CONTEXT_FIRST_FORMAT : SVRTY_CONTEXT_NEXT_FORMAT);
+
+    int rendered = snprintf(context_str + offset, sizeof(context_str) - offset, format, key, value);
+
+    if(rendered < 0 || (size_t)rendered >= sizeof(context_str) - offset)
+    {
+        // Does not fit: previous context is restored.
+        if(context_depth > 0)
+            memcpy(context_str + offset, SVRTY_CONTEXT_CLOSE, SVRTY_CONTEXT_CLOSE_LEN + 1);
+        else
+            context_str[0] = SVRTY_STR_END;
+
+        return SVRTY_LOG_CONTEXT_FULL;
+    }
+
+    context_lens[context_depth++]   = context_str_len;
+    context_str_len                 = offset + rendered;
+
+    return SVRTY_LOG_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////
+/// @brief Pops the last key/value pair pushed into calling thread's
+/// logging context.
+/// @return 0 if succeeded, < 0 if the context was already empty.
+////////////////////////////////////////////////////////////////////
+int SeverityLogContextPop(void)
+{
+    if(context_depth == 0)
+        return SVRTY_LOG_CONTEXT_EMPTY;
+
+    context_str_len = context_lens[--context_depth];
+
+    if(context_str_len == 0)
+    {
+        context_str[0] = SVRTY_STR_END;
+        return SVRTY_LOG_SUCCESS;
+    }
+
+    memcpy(context_str + context_str_len - SVRTY_CONTEXT_CLOSE_LEN, SVRTY_CONTEXT_CLOSE, SVRTY_CONTEXT_CLOSE_LEN + 1);
+
+    return SVRTY_LOG_SUCCESS;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @brief Pops a context pushed by SVRTY_LOG_CONTEXT_SCOPE, if it was pushed.
+/// @param push_result Result of the matching SeverityLogContextPush call.
+//////////////////////////////////////////////////////////////////////////////
+void SeverityLogContextScopeEnd(int* push_result)
+{
+    if(*push_result == SVRTY_LOG_SUCCESS)
+        SeverityLogContextPop();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+/// @brief Tells whether or not a log with the given severity level would be printed.
+/// Sampling is not taken into account (SeverityLogReserve does, as it draws a sample).
+/// @param severity Target severity level.
+/// @return true if the library is initialized and the severity level is not masked.
+///////////////////////////////////////////////////////////////////////////////////////
+bool SeverityLogLevelEnabled(const uint8_t severity)
+{
+    return (SVRTY_CONFIG_LOAD(is_initialized) && (CheckSeverityLogMask(severity) == SVRTY_LOG_SUCCESS));
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+/// @brief Performs every check required before a log is formatted (initialization,
+/// buffer allocation, severity log mask and sampling).
+/// @param severity Target message severity level.
+/// @return SVRTY_LOG_SUCCESS if the log has to be printed, < 0 otherwise.
+///////////////////////////////////////////////////////////////////////////////////
+static int SeverityLogCheck(const int severity)
+{
+    if(!SVRTY_CONFIG_LOAD(is_initialized))
+        return SVRTY_LOG_UNINITIALIZED;
+
+    int check_severity_log_mask = CheckSeverityLogMask(severity);
+
+    if(check_severity_log_mask < 0)
+        return check_severity_log_mask;
+
+    int reserve_thread_buffer = SeverityLogReserveThreadBuffer();
+
+    if(reserve_thread_buffer < 0)
+        return reserve_thread_buffer;
+
+    // Sampled out logs are discarded before any formatting takes place.
+    return CheckSeverityLogSampling(severity);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Builds every prefix string (color, time, level, sampling, exe file name, TID).
+/// Always inlined, as the calling exe file name depends on the call stack depth.
+/// @param severity Severity level (ERR, INF, WNG, DBG)
+/////////////////////////////////////////////////////////////////////////////////////////
+static inline __attribute__((always_inline)) void SeverityLogPreparePrefix(const int severity)
+{
+    ChangeSeverityColor(severity);
+    PrintTime();
+
+    PrintSeverityLevel(severity);
+    PrintSamplingRate(severity);
+    PrintCallingExeFileName();
+    PrintTID();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// @brief Prints every token in a buffer, preceded by the current line prefix.
+/// Output is only flushed once, after the last line has been printed.
+/// @param buffer Tokenized buffer.
+/// @param buffer_len Target buffer length (required because of tokenization).
+///////////////////////////////////////////////////////////////////////////////
+static void SeverityLogPrintLines(const char* buffer, const size_t buffer_len)
+{
+    if(!SVRTY_CONFIG_LOAD(print_to_stdout))
+        return;
+
+    if(output_backend != SVRTY_LOG_BACKEND_STDIO)
+    {
+        SeverityLogWriteLines(buffer, buffer_len);
+        return;
+    }
+
+    const char *ptr = buffer;
+    const char *end = buffer + buffer_len;
+
+    flockfile(stdout);
+
+    // Iterate over tokens
     while (ptr < end)
     {
         if (*ptr != SVRTY_STR_END)
         {
-            printf( "%s%s%s%s%s%s%s%s"  ,
+            printf( "%s%s%s%s%s%s%s%s%s%s",
                     severity_color_str  ,
                     time_date_str       ,
                     severity_level_str  ,
+                    sampling_str        ,
                     file_name_str       ,
                     logging_TID         ,
+                    context_str         ,
                     ptr                 ,
                     SVRTY_RST_CLR       ,
                     SVRTY_CRLF          );
-            fflush(stdout);
             ptr += (strlen(ptr) + 1);
         }
         else
@@ -690,11 +1476,694 @@ int SeverityLog(const uint8_t severity, const char* C_SEVERITY_LOG_RESTRICT form
         }
     }
 
-    ResetSeverityColor();
+    fflush(stdout);
 
-    SVRTY_CLEAN_STR(log_str_buffer);
+    funlockfile(stdout);
+}
 
-    return done;
+//////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Prints a log with different color and initial string depending on the severity level.
+/// @param severity Severity level (ERR, INF, WNG).
+/// @param format Formatted string. Same as what can be used with printf.
+/// @param ... Variable number of arguments. Data that is meant to be formatted and printed.
+/// @return < 0 if any error happened, number of characters written to stream otherwise.
+//////////////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLog(const uint8_t severity, const char* C_SEVERITY_LOG_RESTRICT format, ...)
+{
+    int check_severity_log = SeverityLogCheck(severity);
+
+    if(check_severity_log < 0)
+        return check_severity_log;
+
+    SeverityLogPreparePrefix(severity);
+
+    va_list args;
+    int done;
+
+    va_start(args, format);
+
+    // Calling thread's buffer is private, so formatting takes place out of the lock.
+    done = vsnprintf(   log_str_buffer      ,
+                        log_str_buffer_size ,
+                        format              ,
+                        args                );
+    
+    va_end(args);
+
+    size_t cur_log_str_buffer_len = strlen(log_str_buffer);
+    
+    SeverityLogTokenizeCRLF(log_str_buffer, cur_log_str_buffer_len);
+
+    int staged = SeverityLogStage(severity, log_str_buffer, cur_log_str_buffer_len);
+
+    if(staged != SVRTY_LOG_PERCPU_ERR)
+    {
+        ResetSeverityColor();
+        return (staged == SVRTY_LOG_SUCCESS ? done : staged);
+    }
+
+    MTX_GRD_LOCK_SC(&log_buff_mtx, p_log_buff_mtx);
+
+    SeverityLogSyslog(severity, log_str_buffer, cur_log_str_buffer_len);
+
+    SeverityLogShmLines(severity, log_str_buffer, cur_log_str_buffer_len);
+
+    SeverityLogRecordLines(severity, log_str_buffer, cur_log_str_buffer_len);
+
+    SeverityLogPrintLines(log_str_buffer, cur_log_str_buffer_len);
+
+    SeverityLogErrSyncFlush(severity);
+
+    ResetSeverityColor();
+
+    return done;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/// @brief Same as SeverityLogPrintLines, but lines are gathered (without copying)
+/// and written straight to stdout's file descriptor by using writev or io_uring.
+/// @param buffer Tokenized buffer.
+/// @param buffer_len Target buffer length (required because of tokenization).
+//////////////////////////////////////////////////////////////////////////////////
+static void SeverityLogWriteLines(const char* buffer, const size_t buffer_len)
+{
+    struct iovec iov[SVRTY_IOV_LINES * SVRTY_IOV_PER_LINE];
+    int iovcnt = 0;
+
+    const char* segments[SVRTY_IOV_PER_LINE] = {severity_color_str  ,
+                                                time_date_str       ,
+                                                severity_level_str  ,
+                                                sampling_str        ,
+                                                file_name_str       ,
+                                                logging_TID         ,
+                                                context_str         ,
+                                                NULL                ,   // Payload, set for each line.
+                                                SVRTY_RST_CLR       ,
+                                                SVRTY_CRLF          };
+    size_t segment_lens[SVRTY_IOV_PER_LINE];
+
+    // Prefix does not change from line to line.
+    for(int i = 0; i < SVRTY_IOV_PER_LINE; i++)
+        segment_lens[i] = (segments[i] != NULL ? strlen(segments[i]) : 0);
+
+    const char *ptr = buffer;
+    const char *end = buffer + buffer_len;
+
+    while (ptr < end)
+    {
+        if (*ptr == SVRTY_STR_END)
+        {
+            ++ptr;
+            continue;
+        }
+
+        size_t ptr_len = strlen(ptr);
+
+        segments[SVRTY_IOV_PAYLOAD_IDX]     = ptr;
+        segment_lens[SVRTY_IOV_PAYLOAD_IDX] = ptr_len;
+
+        for(int i = 0; i < SVRTY_IOV_PER_LINE; i++)
+        {
+            if(segment_lens[i] == 0)
+                continue;
+
+            iov[iovcnt].iov_base  = (void*)segments[i];
+            iov[iovcnt].iov_len   = segment_lens[i];
+            ++iovcnt;
+        }
+
+        if(iovcnt > (int)((SVRTY_IOV_LINES - 1) * SVRTY_IOV_PER_LINE))
+        {
+            SeverityLogWriteIovecs(iov, iovcnt);
+            iovcnt = 0;
+        }
+
+        ptr += (ptr_len + 1);
+    }
+
+    if(iovcnt > 0)
+        SeverityLogWriteIovecs(iov, iovcnt);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Writes gathered data to stdout's file descriptor. If io_uring backend is being
+/// used, data is submitted asynchronously. Otherwise, writev is used until every byte
+/// has been written.
+/// @param iov Data to be written. Modified if partial writes happen.
+/// @param iovcnt Number of elements in iov.
+/////////////////////////////////////////////////////////////////////////////////////////
+static void SeverityLogWriteIovecs(struct iovec* iov, int iovcnt)
+{
+    if(output_backend == SVRTY_LOG_BACKEND_IO_URING && SeverityLogUringWrite(STDOUT_FILENO, iov, iovcnt) == 0)
+        return;
+
+    while(iovcnt > 0)
+    {
+        ssize_t written = writev(STDOUT_FILENO, iov, iovcnt);
+
+        if(written < 0 && errno == EINTR)
+            continue;
+
+        if(written <= 0)
+            return;
+
+        // Skip fully written elements, then adjust the partially written one (if any).
+        while(iovcnt > 0 && (size_t)written >= iov->iov_len)
+        {
+            written -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+
+        if(iovcnt > 0)
+        {
+            iov->iov_base   = (char*)iov->iov_base + written;
+            iov->iov_len   -= written;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Selects how logs are written to stdout.
+/// @param backend SVRTY_LOG_BACKEND_STDIO, SVRTY_LOG_BACKEND_WRITEV or SVRTY_LOG_BACKEND_IO_URING.
+/// @return Backend actually in use (io_uring falls back to writev if it is not supported),
+/// < 0 if an invalid backend was provided.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int SetSeverityLogOutputBackend(const uint8_t backend)
+{
+    if(backend > SVRTY_LOG_BACKEND_IO_URING)
+        return SVRTY_LOG_INVALID_BACKEND;
+
+    SeverityLogLazyLoad();
+
+    MTX_GRD_LOCK_SC(&log_buff_mtx, p_log_buff_mtx);
+
+    // Data already buffered by stdio goes first, as the new backend may bypass it.
+    fflush(stdout);
+
+    if(output_backend == SVRTY_LOG_BACKEND_IO_URING && backend != SVRTY_LOG_BACKEND_IO_URING)
+        SeverityLogUringExit();
+
+    output_backend = backend;
+
+    if(backend == SVRTY_LOG_BACKEND_IO_URING && SeverityLogUringInit(SVRTY_URING_BUFFER_AMOUNT, SVRTY_URING_BUFFER_SIZE) < 0)
+        output_backend = SVRTY_LOG_BACKEND_WRITEV;
+
+    return output_backend;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Makes sure every log printed so far has reached stdout (that includes
+/// waiting for asynchronous writes when using io_uring backend).
+////////////////////////////////////////////////////////////////////////////////
+void SeverityLogFlush(void)
+{
+    if(!SVRTY_CONFIG_LOAD(is_loaded))
+        return;
+
+    // Must be done before taking the output mutex, as the writer thread needs it.
+    SeverityLogPerCpuFlush(false);
+
+    SeverityLogFileFlush();
+
+    MTX_GRD_LOCK_SC(&log_buff_mtx, p_log_buff_mtx);
+
+    fflush(stdout);
+
+    if(output_backend == SVRTY_LOG_BACKEND_IO_URING)
+        SeverityLogUringFlush();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+/// @brief Renders every line in a buffer exactly as SeverityLogPrintLines prints them.
+/// @param destination Target memory. If NULL, nothing is written.
+/// @param buffer Tokenized buffer.
+/// @param buffer_len Target buffer length (required because of tokenization).
+/// @return Rendered length.
+///////////////////////////////////////////////////////////////////////////////////////
+static size_t SeverityLogRenderLines(char* destination, const char* buffer, const size_t buffer_len)
+{
+    const char* segments[SVRTY_IOV_PER_LINE] = {severity_color_str  ,
+                                                time_date_str       ,
+                                                severity_level_str  ,
+                                                sampling_str        ,
+                                                file_name_str       ,
+                                                logging_TID         ,
+                                                context_str         ,
+                                                NULL                ,   // Payload, set for each line.
+                                                SVRTY_RST_CLR       ,
+                                                SVRTY_CRLF          };
+    size_t segment_lens[SVRTY_IOV_PER_LINE];
+    size_t rendered_len = 0;
+
+    for(int i = 0; i < SVRTY_IOV_PER_LINE; i++)
+        segment_lens[i] = (segments[i] != NULL ? strlen(segments[i]) : 0);
+
+    const char *ptr = buffer;
+    const char *end = buffer + buffer_len;
+
+    while (ptr < end)
+    {
+        if (*ptr == SVRTY_STR_END)
+        {
+            ++ptr;
+            continue;
+        }
+
+        segments[SVRTY_IOV_PAYLOAD_IDX]     = ptr;
+        segment_lens[SVRTY_IOV_PAYLOAD_IDX] = strlen(ptr);
+
+        for(int i = 0; i < SVRTY_IOV_PER_LINE; i++)
+        {
+            if(destination != NULL)
+                memcpy(destination + rendered_len, segments[i], segment_lens[i]);
+
+            rendered_len += segment_lens[i];
+        }
+
+        ptr += (segment_lens[SVRTY_IOV_PAYLOAD_IDX] + 1);
+    }
+
+    return rendered_len;
+}
+
+/////////////////////////////////////////////////////////
+/// @brief Renders a staged log into its per-CPU segment.
+/// @param destination Target memory within the segment.
+/// @param context Target log (SVRTY_LOG_STAGED).
+/////////////////////////////////////////////////////////
+static void SeverityLogRenderStaged(char* destination, const void* context)
+{
+    const SVRTY_LOG_STAGED* staged = (const SVRTY_LOG_STAGED*)context;
+
+    SeverityLogRenderLines(destination, staged->buffer, staged->buffer_len);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Stages a log into the calling CPU's segment (if per-CPU staging is enabled), so
+/// that the output mutex is not taken. ERR and WNG logs go into the high priority lane,
+/// which is drained first and never dropped. Syslog, shared memory ring, file and capture
+/// sinks are still fed from here, under the output mutex, but only if enabled (even if the
+/// log is dropped, as dropping only applies to stdout).
+/// @param severity Severity level.
+/// @param buffer Tokenized buffer.
+/// @param buffer_len Target buffer length (required because of tokenization).
+/// @return 0 if staged, SVRTY_LOG_WNG_DROPPED if dropped because of the overflow policy,
+/// SVRTY_LOG_PERCPU_ERR if the log has to be printed synchronously.
+///////////////////////////////////////////////////////////////////////////////////////////
+static int SeverityLogStage(const int severity, const char* buffer, const size_t buffer_len)
+{
+    if(!SeverityLogPerCpuIsActive() || !SVRTY_CONFIG_LOAD(print_to_stdout))
+    {
+        SeverityLogPerCpuWaitExit();
+        return SVRTY_LOG_PERCPU_ERR;
+    }
+
+    SVRTY_LOG_STAGED staged = {buffer, buffer_len};
+
+    bool high_priority  = (severity == SVRTY_LVL_ERR || severity == SVRTY_LVL_WNG);
+    int lane            = (high_priority ? SVRTY_PERCPU_LANE_HIGH : SVRTY_PERCPU_LANE_LOW);
+    bool drop_if_full   = (!high_priority && SVRTY_CONFIG_LOAD(overflow_policy) == SVRTY_LOG_OVERFLOW_DROP);
+
+    int stage_result = SeverityLogPerCpuStage(lane, drop_if_full, SeverityLogRenderLines(NULL, buffer, buffer_len), SeverityLogRenderStaged, &staged);
+
+    // Log is printed synchronously instead, record sinks included.
+    if(stage_result < 0 && stage_result != SVRTY_PERCPU_DROPPED)
+        return SVRTY_LOG_PERCPU_ERR;
+
+    // Dropping only applies to stdout: record sinks are fed no matter what.
+    if(SVRTY_CONFIG_LOAD(log_to_syslog) || SeverityLogShmIsOpen() || SeverityLogFileIsOpen() || __atomic_load_n(&capture_callback, __ATOMIC_RELAXED) != NULL)
+    {
+        MTX_GRD_LOCK_SC(&log_buff_mtx, p_log_buff_mtx);
+
+        SeverityLogSyslog(severity, buffer, buffer_len);
+
+        SeverityLogShmLines(severity, buffer, buffer_len);
+
+        SeverityLogRecordLines(severity, buffer, buffer_len);
+    }
+
+    if(stage_result == SVRTY_PERCPU_DROPPED)
+        return SVRTY_LOG_WNG_DROPPED;
+
+    if(severity == SVRTY_LVL_ERR && SVRTY_CONFIG_LOAD(err_sync_flush))
+    {
+        // Only the high priority lane is waited for, no matter how much INF/DBG traffic is staged.
+        SeverityLogPerCpuFlush(true);
+
+        MTX_GRD_LOCK_SC(&log_buff_mtx, p_log_buff_mtx);
+
+        SeverityLogErrSyncFlush(severity);
+    }
+
+    return SVRTY_LOG_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// @brief Prints records merged by the per-CPU writer thread (one lock and one
+/// flush per call, no matter how many records are provided).
+/// @param iov Rendered records.
+/// @param iovcnt Number of records.
+///////////////////////////////////////////////////////////////////////////////
+static void SeverityLogPerCpuOutput(struct iovec* iov, int iovcnt)
+{
+    MTX_GRD_LOCK_SC(&log_buff_mtx, p_log_buff_mtx);
+
+    if(output_backend != SVRTY_LOG_BACKEND_STDIO)
+    {
+        SeverityLogWriteIovecs(iov, iovcnt);
+        return;
+    }
+
+    flockfile(stdout);
+
+    for(int i = 0; i < iovcnt; i++)
+        fwrite(iov[i].iov_base, 1, iov[i].iov_len, stdout);
+
+    fflush(stdout);
+
+    funlockfile(stdout);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// @brief Waits for ERR logs to reach stdout if requested (see
+/// SetSeverityLogErrSyncFlush). Must be called while holding the output mutex.
+/// Other backends are already synchronous once the log has been printed.
+/// @param severity Severity level.
+///////////////////////////////////////////////////////////////////////////////
+static void SeverityLogErrSyncFlush(const int severity)
+{
+    if(severity == SVRTY_LVL_ERR && SVRTY_CONFIG_LOAD(err_sync_flush) && output_backend == SVRTY_LOG_BACKEND_IO_URING)
+        SeverityLogUringFlush();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Stages logs into per-CPU buffers instead of printing them under a single mutex. A
+/// writer thread drains them, merging records by timestamp so that output order is preserved.
+/// @param enable Enable (T) or disable (F, every staged log is printed before returning).
+/// @param segment_size Size of each CPU's staging buffer (0 sets the default one).
+/// @param writer_cpus CPUs the writer thread is pinned to (NULL does not pin it).
+/// @param writer_cpu_amount Number of elements in writer_cpus.
+/// @return 0 if succeeded, < 0 otherwise.
+//////////////////////////////////////////////////////////////////////////////////////////////
+int SetSeverityLogPerCpuStaging(const bool enable, const size_t segment_size, const int* writer_cpus, const size_t writer_cpu_amount)
+{
+    SeverityLogLazyLoad();
+
+    if(!enable)
+    {
+        SeverityLogPerCpuExit();
+        return SVRTY_LOG_SUCCESS;
+    }
+
+    size_t target_segment_size = (segment_size == 0 ? SVRTY_PERCPU_SEGMENT_SIZE : segment_size);
+
+    if(SeverityLogPerCpuInit(target_segment_size, writer_cpus, writer_cpu_amount, SeverityLogPerCpuOutput) < 0)
+        return SVRTY_LOG_PERCPU_ERR;
+
+    return SVRTY_LOG_SUCCESS;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Selects what happens to INF and DBG logs when their per-CPU staging buffer is full.
+/// ERR and WNG logs are staged apart (and drained first), so they are never dropped.
+/// @param policy SVRTY_LOG_OVERFLOW_BLOCK or SVRTY_LOG_OVERFLOW_DROP.
+/// @return 0 if succeeded, < 0 if an invalid policy was provided.
+//////////////////////////////////////////////////////////////////////////////////////////////
+int SetSeverityLogOverflowPolicy(const uint8_t policy)
+{
+    if(policy != SVRTY_LOG_OVERFLOW_BLOCK && policy != SVRTY_LOG_OVERFLOW_DROP)
+        return SVRTY_LOG_INVALID_POLICY;
+
+    SVRTY_CONFIG_STORE(overflow_policy, policy);
+
+    return SVRTY_LOG_SUCCESS;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/// @brief Sets whether ERR logs return only once they have reached stdout, even when
+/// they are staged or written asynchronously (io_uring backend).
+/// @param sync_flush_status Flush ERR logs synchronously (T/F).
+/////////////////////////////////////////////////////////////////////////////////////
+void SetSeverityLogErrSyncFlush(const bool sync_flush_status)
+{
+    SVRTY_CONFIG_STORE(err_sync_flush, sync_flush_status);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @brief Gets the number of logs dropped because of SVRTY_LOG_OVERFLOW_DROP.
+/// @return Number of dropped logs.
+//////////////////////////////////////////////////////////////////////////////
+uint64_t SeverityLogGetDroppedCount(void)
+{
+    return SeverityLogPerCpuDropped();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Prints a payload already placed into calling thread's log buffer. Always inlined,
+/// as the calling exe file name depends on the call stack depth.
+/// @param severity Severity level (ERR, INF, WNG, DBG).
+/// @param payload_len Payload length. Longer payloads than the buffer itself get truncated.
+/// @return < 0 if any error happened, number of payload characters printed otherwise.
+////////////////////////////////////////////////////////////////////////////////////////////
+static inline __attribute__((always_inline)) int SeverityLogPrintPayload(const uint8_t severity, const size_t payload_len)
+{
+    SeverityLogPreparePrefix(severity);
+
+    // Same limit as SeverityLog's: longer payloads get truncated.
+    size_t cur_log_str_buffer_len = payload_len;
+
+    if(cur_log_str_buffer_len >= log_str_buffer_size)
+        cur_log_str_buffer_len = log_str_buffer_size - 1;
+
+    log_str_buffer[cur_log_str_buffer_len] = SVRTY_STR_END;
+
+    SeverityLogTokenizeCRLF(log_str_buffer, cur_log_str_buffer_len);
+
+    int staged = SeverityLogStage(severity, log_str_buffer, cur_log_str_buffer_len);
+
+    if(staged != SVRTY_LOG_PERCPU_ERR)
+    {
+        ResetSeverityColor();
+        return (staged == SVRTY_LOG_SUCCESS ? (int)cur_log_str_buffer_len : staged);
+    }
+
+    MTX_GRD_LOCK_SC(&log_buff_mtx, p_log_buff_mtx);
+
+    SeverityLogSyslog(severity, log_str_buffer, cur_log_str_buffer_len);
+
+    SeverityLogShmLines(severity, log_str_buffer, cur_log_str_buffer_len);
+
+    SeverityLogRecordLines(severity, log_str_buffer, cur_log_str_buffer_len);
+
+    SeverityLogPrintLines(log_str_buffer, cur_log_str_buffer_len);
+
+    SeverityLogErrSyncFlush(severity);
+
+    ResetSeverityColor();
+
+    return (int)cur_log_str_buffer_len;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Prints an already formatted log. Same as SeverityLog, but no format is parsed.
+/// @param severity Severity level (ERR, INF, WNG, DBG).
+/// @param payload Log payload. It does not need to be null-terminated.
+/// @param payload_len Payload length.
+/// @return < 0 if any error happened, number of payload characters printed otherwise.
+/////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogStr(const uint8_t severity, const char* payload, const size_t payload_len)
+{
+    int check_severity_log = SeverityLogCheck(severity);
+
+    if(check_severity_log < 0)
+        return check_severity_log;
+
+    // Lines are split in place, so the payload is copied into calling thread's buffer first.
+    memcpy(log_str_buffer, payload, (payload_len < log_str_buffer_size ? payload_len : log_str_buffer_size - 1));
+
+    return SeverityLogPrintPayload(severity, payload_len);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Performs every check SeverityLog does before formatting (sampling included) and,
+/// if the log has to be printed, lends calling thread's log buffer so that the payload can
+/// be written straight into it. Payload is printed by SeverityLogCommit.
+/// @param severity Severity level (ERR, INF, WNG, DBG).
+/// @param payload Set to calling thread's log buffer.
+/// @param payload_capacity Set to the maximum payload length (same limit as SeverityLog's).
+/// @return 0 if the log has to be printed, < 0 otherwise (nothing has to be committed then).
+/////////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogReserve(const uint8_t severity, char** payload, size_t* payload_capacity)
+{
+    int check_severity_log = SeverityLogCheck(severity);
+
+    if(check_severity_log < 0)
+        return check_severity_log;
+
+    *payload            = log_str_buffer;
+    *payload_capacity   = log_str_buffer_size - 1;
+
+    return SVRTY_LOG_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Prints a payload written into the buffer lent by SeverityLogReserve. Nothing else
+/// may be logged by the calling thread in between.
+/// @param severity Severity level (same as the one provided to SeverityLogReserve).
+/// @param payload_len Payload length.
+/// @return < 0 if any error happened, number of payload characters printed otherwise.
+////////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogCommit(const uint8_t severity, const size_t payload_len)
+{
+    if(log_str_buffer == NULL)
+        return SVRTY_LOG_UNINITIALIZED;
+
+    return SeverityLogPrintPayload(severity, payload_len);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Starts a batch of logs sharing the same severity level, prefix and timestamp.
+/// If sampling is enabled for the severity level, it is decided here for the whole batch.
+/// @param batch Target batch.
+/// @param severity Severity level of every log in the batch.
+/// @param buffer Caller-owned buffer in which logs are accumulated until commit.
+/// @param buffer_size Caller-owned buffer size.
+/// @return 0 if succeeded, < 0 otherwise (for instance, if the severity level is masked or
+/// the batch is sampled out). Appending to and committing the batch returns the same then.
+///////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogBatchBegin(SVRTY_LOG_BATCH* batch, const uint8_t severity, char* buffer, const size_t buffer_size)
+{
+    if(batch == NULL)
+        return SVRTY_LOG_BATCH_INVALID;
+
+    batch->buffer           = buffer        ;
+    batch->buffer_size      = buffer_size   ;
+    batch->length           = 0             ;
+    batch->payload_length   = 0             ;
+    batch->severity         = severity      ;
+    batch->status           = SVRTY_LOG_SUCCESS;
+
+    if(buffer == NULL || buffer_size < SVRTY_BATCH_MIN_SIZE)
+        batch->status = SVRTY_LOG_BATCH_INVALID;
+    else if(!SVRTY_CONFIG_LOAD(is_initialized))
+        batch->status = SVRTY_LOG_UNINITIALIZED;
+    else
+        batch->status = CheckSeverityLogMask(severity);
+
+    // Sampling is decided once for the whole batch, so that appending never fails because of it.
+    if(batch->status == SVRTY_LOG_SUCCESS)
+        batch->status = CheckSeverityLogSampling(severity);
+
+    if(batch->status == SVRTY_LOG_SUCCESS)
+        batch->buffer[0] = SVRTY_STR_END;
+
+    return batch->status;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Appends a log to a batch. Nothing is printed until the batch is committed.
+/// @param batch Target batch, as initialized by SeverityLogBatchBegin.
+/// @param format Formatted string. Same as what can be used with printf.
+/// @param ... Variable number of arguments. Data that is meant to be formatted and printed.
+/// @return SVRTY_LOG_BATCH_FULL if the log does not fit (commit the batch, then append it again), another
+/// value < 0 if the batch is not meant to be printed (see SeverityLogBatchBegin), number of appended
+/// characters otherwise.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogBatchAppend(SVRTY_LOG_BATCH* batch, const char* C_SEVERITY_LOG_RESTRICT format, ...)
+{
+    if(batch == NULL)
+        return SVRTY_LOG_BATCH_INVALID;
+
+    if(batch->status < 0)
+        return batch->status;
+
+    // Room for the line feed that separates logs within the batch is kept as well.
+    size_t available = batch->buffer_size - batch->length - 1;
+
+    va_list args;
+
+    va_start(args, format);
+
+    int done = vsnprintf(   (batch->buffer + batch->length) ,
+                            available                       ,
+                            format                          ,
+                            args                            );
+
+    va_end(args);
+
+    if(done < 0 || (size_t)done >= available)
+    {
+        // Do not keep truncated logs: roll the buffer back and let the caller commit first.
+        batch->buffer[batch->length] = SVRTY_STR_END;
+        return SVRTY_LOG_BATCH_FULL;
+    }
+
+    batch->length           += done;
+    batch->payload_length   += done;
+    batch->buffer[batch->length++]  = SVRTY_LF;
+    batch->buffer[batch->length]    = SVRTY_STR_END;
+
+    return done;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Prints every log accumulated in a batch by using a single lock and a single flush.
+/// Every line gets the same prefix as SeverityLog would print. The batch is emptied afterwards.
+/// @param batch Target batch, as initialized by SeverityLogBatchBegin.
+/// @return < 0 if any error happened, number of payload characters printed otherwise (the sum of
+/// every SeverityLogBatchAppend result, line feeds separating logs excluded).
+/////////////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogBatchCommit(SVRTY_LOG_BATCH* batch)
+{
+    if(batch == NULL)
+        return SVRTY_LOG_BATCH_INVALID;
+
+    if(batch->status < 0)
+        return batch->status;
+
+    size_t batch_len        = batch->length;
+    size_t payload_len      = batch->payload_length;
+
+    if(batch_len == 0)
+        return SVRTY_LOG_SUCCESS;
+
+    batch->length           = 0;
+    batch->payload_length   = 0;
+
+    // Prefix (including timestamp) is computed once for the whole batch.
+    SeverityLogPreparePrefix(batch->severity);
+
+    SeverityLogTokenizeCRLF(batch->buffer, batch_len);
+
+    int staged = SeverityLogStage(batch->severity, batch->buffer, batch_len);
+
+    if(staged != SVRTY_LOG_PERCPU_ERR)
+    {
+        ResetSeverityColor();
+
+        batch->buffer[0] = SVRTY_STR_END;
+
+        return (staged == SVRTY_LOG_SUCCESS ? (int)payload_len : staged);
+    }
+
+    MTX_GRD_LOCK_SC(&log_buff_mtx, p_log_buff_mtx);
+
+    SeverityLogSyslog(batch->severity, batch->buffer, batch_len);
+
+    SeverityLogShmLines(batch->severity, batch->buffer, batch_len);
+
+    SeverityLogRecordLines(batch->severity, batch->buffer, batch_len);
+
+    SeverityLogPrintLines(batch->buffer, batch_len);
+
+    SeverityLogErrSyncFlush(batch->severity);
+
+    ResetSeverityColor();
+
+    batch->buffer[0] = SVRTY_STR_END;
+
+    return (int)payload_len;
 }
 
 /*************************************/
@@ -0,0 +1,1197 @@
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "SeverityLogFile.h"
+#include "SeverityLogFile_api.h"
+#include "SeverityLogLz.h"
+
+/************************************/
+
+/***********************************/
+/******** Define statements ********/
+/***********************************/
+
+#define SVRTY_FILE_DEFAULT_BLOCK_SIZE   (64 * 1024)
+#define SVRTY_FILE_MIN_BLOCK_SIZE       4096
+#define SVRTY_FILE_MAX_BLOCK_SIZE       (16 * 1024 * 1024)
+#define SVRTY_FILE_INDEX_MIN_CAPACITY   64
+#define SVRTY_FILE_SEALED_BLOCKS        4           // Full blocks waiting for the writer thread before the queue grows.
+#define SVRTY_FILE_PERIOD_NS            1000000000L // Partially filled blocks are written at least this often (1 s).
+#define SVRTY_FILE_MODE                 0644
+#define SVRTY_FILE_SIDECAR_MAX_RECORDS  UINT16_MAX  // Sidecar entries' record_amount is 16 bits long.
+
+#define SVRTY_FILE_NS_PER_SEC   1000000000L
+
+// Layout is documented in SeverityLogFile_api.h, so it must not change unnoticed.
+_Static_assert(sizeof(SVRTY_FILE_HEADER)          == 32, "Unexpected log file header size.");
+_Static_assert(sizeof(SVRTY_FILE_BLOCK)           == 32, "Unexpected log file block header size.");
+_Static_assert(sizeof(SVRTY_FILE_RECORD)          == 16, "Unexpected log file record header size.");
+_Static_assert(sizeof(SVRTY_FILE_INDEX_ENTRY)     == 32, "Unexpected log file index entry size.");
+_Static_assert(sizeof(SVRTY_FILE_TRAILER)         == 16, "Unexpected log file trailer size.");
+_Static_assert(sizeof(SVRTY_FILE_SIDECAR_HEADER)  == 16, "Unexpected sidecar index header size.");
+_Static_assert(sizeof(SVRTY_FILE_SIDECAR_ENTRY)   == 24, "Unexpected sidecar index entry size.");
+
+/***********************************/
+
+/**********************************/
+/******** Type definitions ********/
+/**********************************/
+
+/// @brief Block being filled by loggers, or waiting to be written.
+typedef struct
+{
+    uint8_t*                    data            ;   // Records.
+    size_t                      used            ;   // Bytes in use within data.
+    uint32_t                    record_amount   ;   // Number of records.
+    uint64_t                    first_ns        ;   // First record's timestamp.
+    uint64_t                    last_ns         ;   // Last record's timestamp.
+    SVRTY_FILE_SIDECAR_ENTRY*   marks           ;   // Sidecar index entries (block_offset is set once written).
+    uint32_t                    mark_amount     ;   // Number of sidecar index entries.
+} SVRTY_FILE_PENDING_BLOCK;
+
+/// @brief Full blocks waiting for the writer thread, oldest first (ring buffer).
+typedef struct
+{
+    SVRTY_FILE_PENDING_BLOCK*   blocks      ;   // Slots, each one with its own buffers.
+    unsigned int                capacity    ;   // Number of slots.
+    unsigned int                head        ;   // Oldest block.
+    unsigned int                amount      ;   // Blocks waiting.
+} SVRTY_FILE_SEALED_QUEUE;
+
+/**********************************/
+
+/***********************************/
+/******** Private variables ********/
+/***********************************/
+
+static pthread_mutex_t          file_mtx            = PTHREAD_MUTEX_INITIALIZER ;
+static pthread_cond_t           file_writer_cond    = PTHREAD_COND_INITIALIZER  ;
+static pthread_cond_t           file_written_cond   = PTHREAD_COND_INITIALIZER  ;
+static pthread_t                file_writer                                     ;
+static bool                     file_open           = false                     ;
+static bool                     file_writer_stop    = false                     ;
+static uint64_t                 flush_requested     = 0                         ;
+static uint64_t                 flush_done          = 0                         ;
+static int                      file_fd             = -1                        ;
+static uint8_t                  file_compression    = 0                         ;
+static size_t                   file_block_size     = 0                         ;
+static SVRTY_FILE_PENDING_BLOCK active_block        = {0}                       ;
+static SVRTY_FILE_SEALED_QUEUE  sealed_queue        = {0}                       ;
+static uint64_t                 file_dropped        = 0                         ;
+static uint8_t*                 stored_block        = NULL                      ;   // Writer-private: compressed block.
+static uint64_t                 file_offset         = 0                         ;   // Writer-private.
+static SVRTY_FILE_INDEX_ENTRY*  file_index          = NULL                      ;   // Writer-private.
+static uint32_t                 file_index_amount   = 0                         ;
+static uint32_t                 file_index_capacity = 0                         ;
+static bool                     file_index_valid    = true                      ;
+static int                      sidecar_fd          = -1                        ;
+static uint32_t                 sidecar_records     = 0                         ;
+static uint32_t                 sidecar_bytes       = 0                         ;
+static uint32_t                 mark_capacity       = 0                         ;
+
+/***********************************/
+
+/*************************************/
+/**** Private function prototypes ****/
+/*************************************/
+
+static int SeverityLogFileWriteAll(const int fd, const void* data, size_t length);
+static char* SeverityLogFileSidecarPath(const char* path);
+static void SeverityLogFileFree(void);
+static int SeverityLogFileSidecarCreate(const char* path);
+static int SeverityLogFileAllocBlock(SVRTY_FILE_PENDING_BLOCK* block);
+static int SeverityLogFileGrowQueue(void);
+static void SeverityLogFileSeal(void);
+static void SeverityLogFileMark(const uint8_t severity, const uint64_t timestamp_ns);
+static void SeverityLogFileWriteSealed(void);
+static void* SeverityLogFileWriter(void* arg);
+static int SeverityLogFileReaderAddBlock(SVRTY_FILE_READER* reader, uint32_t* capacity, const SVRTY_FILE_INDEX_ENTRY* entry);
+static int SeverityLogFileReaderRebuildIndex(SVRTY_FILE_READER* reader, const char* path, const uint64_t file_size);
+
+/*************************************/
+
+/*************************************/
+/******* Function definitions ********/
+/*************************************/
+
+////////////////////////////////////////////////////////////////
+/// @brief Writes a whole buffer, retrying after partial writes.
+/// @param fd Target file descriptor.
+/// @param data Data to be written.
+/// @param length Data length.
+/// @return 0 if succeeded, < 0 otherwise.
+////////////////////////////////////////////////////////////////
+static int SeverityLogFileWriteAll(const int fd, const void* data, size_t length)
+{
+    const uint8_t* ptr = (const uint8_t*)data;
+
+    while(length > 0)
+    {
+        ssize_t written = write(fd, ptr, length);
+
+        if(written < 0 && errno == EINTR)
+            continue;
+
+        if(written <= 0)
+            return SVRTY_FILE_OPEN_ERR;
+
+        ptr     += written;
+        length  -= (size_t)written;
+    }
+
+    return SVRTY_FILE_SUCCESS;
+}
+
+/////////////////////////////////////////////////////////////
+/// @brief Builds the path of a log file's sidecar index.
+/// @param path Log file path.
+/// @return Sidecar index path (to be freed), NULL if failed.
+/////////////////////////////////////////////////////////////
+static char* SeverityLogFileSidecarPath(const char* path)
+{
+    size_t path_len     = strlen(path);
+    size_t suffix_len   = strlen(SVRTY_FILE_SIDECAR_SUFFIX);
+    char* sidecar_path  = (char*)malloc(path_len + suffix_len + 1);
+
+    if(sidecar_path == NULL)
+        return NULL;
+
+    memcpy(sidecar_path, path, path_len);
+    memcpy(sidecar_path + path_len, SVRTY_FILE_SIDECAR_SUFFIX, suffix_len + 1);
+
+    return sidecar_path;
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// @brief Frees every block buffer, the block index and the sidecar marks.
+///////////////////////////////////////////////////////////////////////////
+static void SeverityLogFileFree(void)
+{
+    free(active_block.data);
+    free(active_block.marks);
+
+    for(unsigned int i = 0; i < sealed_queue.capacity; i++)
+    {
+        free(sealed_queue.blocks[i].data);
+        free(sealed_queue.blocks[i].marks);
+    }
+
+    free(sealed_queue.blocks);
+    free(stored_block);
+    free(file_index);
+
+    memset(&active_block, 0, sizeof(active_block));
+    memset(&sealed_queue, 0, sizeof(sealed_queue));
+
+    stored_block        = NULL;
+    file_index          = NULL;
+    file_index_amount   = 0;
+    file_index_capacity = 0;
+    mark_capacity       = 0;
+
+    if(sidecar_fd >= 0)
+        close(sidecar_fd);
+
+    sidecar_fd = -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Creates (or truncates) the sidecar index, if enabled, and allocates the marks of every
+/// block. Must be called holding file_mtx, once sidecar_records/sidecar_bytes are set.
+/// @param path Log file path.
+/// @return 0 if succeeded, < 0 otherwise.
+/////////////////////////////////////////////////////////////////////////////////////////////////
+static int SeverityLogFileSidecarCreate(const char* path)
+{
+    char* sidecar_path = SeverityLogFileSidecarPath(path);
+
+    if(sidecar_path == NULL)
+        return SVRTY_FILE_OPEN_ERR;
+
+    // A sidecar index left by a previous file would not match the new one.
+    if(sidecar_records == 0 && sidecar_bytes == 0)
+    {
+        unlink(sidecar_path);
+        free(sidecar_path);
+        return SVRTY_FILE_SUCCESS;
+    }
+
+    // Every span closed because of a limit adds an entry, and every entry holds one record at least.
+    size_t max_records  = file_block_size / sizeof(SVRTY_FILE_RECORD);
+    size_t capacity     = 1 + max_records / SVRTY_FILE_SIDECAR_MAX_RECORDS;
+
+    if(sidecar_records > 0)
+        capacity += max_records / sidecar_records;
+
+    if(sidecar_bytes > 0)
+        capacity += file_block_size / sidecar_bytes;
+
+    mark_capacity = (uint32_t)(capacity < max_records ? capacity : max_records);
+
+    active_block.marks = (SVRTY_FILE_SIDECAR_ENTRY*)malloc(mark_capacity * sizeof(SVRTY_FILE_SIDECAR_ENTRY));
+
+    bool marks_allocated = (active_block.marks != NULL);
+
+    for(unsigned int i = 0; i < sealed_queue.capacity; i++)
+    {
+        sealed_queue.blocks[i].marks = (SVRTY_FILE_SIDECAR_ENTRY*)malloc(mark_capacity * sizeof(SVRTY_FILE_SIDECAR_ENTRY));
+        marks_allocated &= (sealed_queue.blocks[i].marks != NULL);
+    }
+
+    if(!marks_allocated)
+    {
+        free(sidecar_path);
+        return SVRTY_FILE_OPEN_ERR;
+    }
+
+    sidecar_fd = open(sidecar_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, SVRTY_FILE_MODE);
+
+    free(sidecar_path);
+
+    SVRTY_FILE_SIDECAR_HEADER header = {SVRTY_FILE_SIDECAR_MAGIC, SVRTY_FILE_SIDECAR_VERSION, 0, sidecar_records, sidecar_bytes};
+
+    if(sidecar_fd < 0 || SeverityLogFileWriteAll(sidecar_fd, &header, sizeof(header)) < 0)
+        return SVRTY_FILE_OPEN_ERR;
+
+    return SVRTY_FILE_SUCCESS;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Creates (or truncates) a log file and starts the writer thread that compresses
+/// and writes its blocks.
+/// @param path File path.
+/// @param compression SVRTY_LOG_FILE_COMPRESSION_NONE or SVRTY_LOG_FILE_COMPRESSION_LZ.
+/// @param block_size Maximum raw block length (0 sets the default one).
+/// @param index_records Sidecar index entry every index_records records (0: no limit).
+/// @param index_bytes Sidecar index entry every index_bytes raw bytes (0: no limit).
+/// No sidecar index is written if both are 0.
+/// @return 0 if succeeded, < 0 otherwise.
+/////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogFileOpen(const char* path, const uint8_t compression, const size_t block_size, const uint32_t index_records, const uint32_t index_bytes)
+{
+    size_t target_block_size = (block_size == 0 ? SVRTY_FILE_DEFAULT_BLOCK_SIZE : block_size);
+
+    if(target_block_size < SVRTY_FILE_MIN_BLOCK_SIZE)
+        target_block_size = SVRTY_FILE_MIN_BLOCK_SIZE;
+
+    if(target_block_size > SVRTY_FILE_MAX_BLOCK_SIZE)
+        target_block_size = SVRTY_FILE_MAX_BLOCK_SIZE;
+
+    target_block_size &= ~((size_t)SVRTY_FILE_RECORD_ALIGNMENT - 1);
+
+    pthread_mutex_lock(&file_mtx);
+
+    if(file_open)
+    {
+        pthread_mutex_unlock(&file_mtx);
+        return SVRTY_FILE_OPEN_ERR;
+    }
+
+    file_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, SVRTY_FILE_MODE);
+
+    if(file_fd < 0)
+    {
+        pthread_mutex_unlock(&file_mtx);
+        return SVRTY_FILE_OPEN_ERR;
+    }
+
+    SVRTY_FILE_HEADER header = {0};
+
+    header.magic        = SVRTY_FILE_MAGIC              ;
+    header.version      = SVRTY_FILE_VERSION            ;
+    header.compression  = compression                   ;
+    header.block_size   = (uint32_t)target_block_size   ;
+
+    file_compression    = compression;
+    file_block_size     = target_block_size;
+    file_offset         = sizeof(header);
+    file_index_valid    = true;
+    sidecar_records     = index_records;
+    sidecar_bytes       = index_bytes;
+    file_writer_stop    = false;
+    flush_requested     = 0;
+    flush_done          = 0;
+
+    __atomic_store_n(&file_dropped, 0, __ATOMIC_RELAXED);
+
+    active_block.data   = (uint8_t*)malloc(target_block_size);
+    stored_block        = (uint8_t*)malloc(SVRTY_LZ_BOUND(target_block_size));
+    sealed_queue.blocks = (SVRTY_FILE_PENDING_BLOCK*)calloc(SVRTY_FILE_SEALED_BLOCKS, sizeof(SVRTY_FILE_PENDING_BLOCK));
+
+    bool blocks_allocated = (active_block.data != NULL && sealed_queue.blocks != NULL);
+
+    if(sealed_queue.blocks != NULL)
+        sealed_queue.capacity = SVRTY_FILE_SEALED_BLOCKS;
+
+    for(unsigned int i = 0; i < sealed_queue.capacity; i++)
+    {
+        sealed_queue.blocks[i].data = (uint8_t*)malloc(target_block_size);
+        blocks_allocated &= (sealed_queue.blocks[i].data != NULL);
+    }
+
+    if( !blocks_allocated                                                       ||
+        stored_block == NULL                                                    ||
+        SeverityLogFileWriteAll(file_fd, &header, sizeof(header)) < 0           ||
+        SeverityLogFileSidecarCreate(path) < 0                                  ||
+        pthread_create(&file_writer, NULL, SeverityLogFileWriter, NULL) != 0    )
+    {
+        SeverityLogFileFree();
+        close(file_fd);
+        file_fd = -1;
+
+        pthread_mutex_unlock(&file_mtx);
+        return SVRTY_FILE_OPEN_ERR;
+    }
+
+    file_open = true;
+
+    pthread_mutex_unlock(&file_mtx);
+
+    return SVRTY_FILE_SUCCESS;
+}
+
+////////////////////////////////////////////
+/// @brief Tells whether a log file is open.
+/// @return true if open, false otherwise.
+////////////////////////////////////////////
+bool SeverityLogFileIsOpen(void)
+{
+    return __atomic_load_n(&file_open, __ATOMIC_RELAXED);
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+/// @brief Allocates the buffers of a sealed queue slot (marks only if there is a
+/// sidecar index). Must be called holding file_mtx.
+/// @param block Target slot.
+/// @return 0 if succeeded, < 0 otherwise (nothing is left allocated).
+/////////////////////////////////////////////////////////////////////////////////
+static int SeverityLogFileAllocBlock(SVRTY_FILE_PENDING_BLOCK* block)
+{
+    memset(block, 0, sizeof(*block));
+
+    block->data = (uint8_t*)malloc(file_block_size);
+
+    if(block->data != NULL && mark_capacity > 0)
+        block->marks = (SVRTY_FILE_SIDECAR_ENTRY*)malloc(mark_capacity * sizeof(SVRTY_FILE_SIDECAR_ENTRY));
+
+    if(block->data == NULL || (mark_capacity > 0 && block->marks == NULL))
+    {
+        free(block->data);
+        free(block->marks);
+        memset(block, 0, sizeof(*block));
+
+        return SVRTY_FILE_OPEN_ERR;
+    }
+
+    return SVRTY_FILE_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+/// @brief Doubles the sealed queue capacity, so that records which must not be dropped
+/// are chained in further blocks while the writer thread catches up. Waiting blocks
+/// are moved to the start of the new ring, so the one being written (head) stays
+/// first. Must be called holding file_mtx, with the queue full.
+/// @return 0 if succeeded, < 0 otherwise (the queue is left as it was).
+///////////////////////////////////////////////////////////////////////////////////////
+static int SeverityLogFileGrowQueue(void)
+{
+    unsigned int new_capacity = sealed_queue.capacity * 2;
+    SVRTY_FILE_PENDING_BLOCK* new_blocks = (SVRTY_FILE_PENDING_BLOCK*)calloc(new_capacity, sizeof(SVRTY_FILE_PENDING_BLOCK));
+
+    if(new_blocks == NULL)
+        return SVRTY_FILE_OPEN_ERR;
+
+    for(unsigned int i = sealed_queue.capacity; i < new_capacity; i++)
+    {
+        if(SeverityLogFileAllocBlock(&new_blocks[i]) < 0)
+        {
+            for(unsigned int j = sealed_queue.capacity; j < i; j++)
+            {
+                free(new_blocks[j].data);
+                free(new_blocks[j].marks);
+            }
+
+            free(new_blocks);
+            return SVRTY_FILE_OPEN_ERR;
+        }
+    }
+
+    for(unsigned int i = 0; i < sealed_queue.capacity; i++)
+        new_blocks[i] = sealed_queue.blocks[(sealed_queue.head + i) % sealed_queue.capacity];
+
+    free(sealed_queue.blocks);
+
+    sealed_queue.blocks     = new_blocks;
+    sealed_queue.capacity   = new_capacity;
+    sealed_queue.head       = 0;
+
+    return SVRTY_FILE_SUCCESS;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// @brief Queues the active block for the writer thread. Must be called while holding
+/// file_mtx, with fewer than sealed_queue.capacity blocks waiting to be written.
+//////////////////////////////////////////////////////////////////////////////////////
+static void SeverityLogFileSeal(void)
+{
+    unsigned int tail = (sealed_queue.head + sealed_queue.amount) % sealed_queue.capacity;
+    SVRTY_FILE_PENDING_BLOCK swap = sealed_queue.blocks[tail];
+
+    sealed_queue.blocks[tail]   = active_block;
+    active_block                = swap;
+
+    active_block.used           = 0;
+    active_block.record_amount  = 0;
+    active_block.mark_amount    = 0;
+
+    ++sealed_queue.amount;
+
+    pthread_cond_signal(&file_writer_cond);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// @brief Adds the record about to be appended to the current sidecar index entry, or
+/// starts a new one if the current one is full. Must be called holding file_mtx.
+/// @param severity Severity level.
+/// @param timestamp_ns Record timestamp.
+//////////////////////////////////////////////////////////////////////////////////////
+static void SeverityLogFileMark(const uint8_t severity, const uint64_t timestamp_ns)
+{
+    SVRTY_FILE_SIDECAR_ENTRY* mark = NULL;
+
+    if(active_block.mark_amount > 0)
+        mark = &active_block.marks[active_block.mark_amount - 1];
+
+    bool span_full = (  mark == NULL                                                                        ||
+                        mark->record_amount >= SVRTY_FILE_SIDECAR_MAX_RECORDS                               ||
+                        (sidecar_records > 0 && mark->record_amount >= sidecar_records)                     ||
+                        (sidecar_bytes > 0 && active_block.used - mark->record_offset >= sidecar_bytes)     );
+
+    if(span_full && active_block.mark_amount < mark_capacity)
+    {
+        mark = &active_block.marks[active_block.mark_amount++];
+
+        memset(mark, 0, sizeof(*mark));
+
+        mark->timestamp_ns  = timestamp_ns;
+        mark->record_offset = (uint32_t)active_block.used;
+    }
+
+    mark->record_amount++;
+    mark->severity_mask |= (uint8_t)SVRTY_FILE_SEVERITY_BIT(severity);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Appends a record to the current block. Once full, the block is queued for the
+/// writer thread. Callers never wait for it (they hold the output mutex): if the writer
+/// falls sealed_queue.capacity blocks behind, droppable records are dropped and counted,
+/// while the rest are chained in further blocks (the queue grows) until it catches up.
+/// @param severity Severity level.
+/// @param timestamp_ns CLOCK_REALTIME timestamp, in nanoseconds.
+/// @param segments Line segments (prefix and payload), concatenated into a single line.
+/// @param segment_amount Number of segments.
+/// @param droppable true if the record may be dropped while the writer is behind.
+/////////////////////////////////////////////////////////////////////////////////////////
+void SeverityLogFileAppend(const uint8_t severity, const uint64_t timestamp_ns, const struct iovec* segments, const int segment_amount, const bool droppable)
+{
+    size_t line_len = 0;
+
+    for(int i = 0; i < segment_amount; i++)
+        line_len += segments[i].iov_len;
+
+    pthread_mutex_lock(&file_mtx);
+
+    if(!file_open)
+    {
+        pthread_mutex_unlock(&file_mtx);
+        return;
+    }
+
+    // Lines longer than a block get truncated.
+    if(line_len > file_block_size - sizeof(SVRTY_FILE_RECORD))
+        line_len = file_block_size - sizeof(SVRTY_FILE_RECORD);
+
+    size_t record_size = SVRTY_FILE_RECORD_SIZE(line_len);
+
+    if(active_block.used + record_size > file_block_size)
+    {
+        // Records are only dropped if allowed to, or if there is no memory left to hold them.
+        if(sealed_queue.amount == sealed_queue.capacity && (droppable || SeverityLogFileGrowQueue() < 0))
+        {
+            __atomic_add_fetch(&file_dropped, 1, __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&file_mtx);
+            return;
+        }
+
+        SeverityLogFileSeal();
+    }
+
+    if(sidecar_fd >= 0)
+        SeverityLogFileMark(severity, timestamp_ns);
+
+    SVRTY_FILE_RECORD* record = (SVRTY_FILE_RECORD*)(active_block.data + active_block.used);
+
+    memset(record, 0, record_size);
+
+    record->timestamp_ns    = timestamp_ns      ;
+    record->length          = (uint32_t)line_len;
+    record->severity        = severity          ;
+
+    size_t copied = 0;
+
+    for(int i = 0; i < segment_amount && copied < line_len; i++)
+    {
+        size_t segment_len = (segments[i].iov_len < line_len - copied ? segments[i].iov_len : line_len - copied);
+
+        memcpy(record->line + copied, segments[i].iov_base, segment_len);
+        copied += segment_len;
+    }
+
+    if(active_block.record_amount == 0)
+        active_block.first_ns = timestamp_ns;
+
+    active_block.last_ns = timestamp_ns;
+    active_block.record_amount++;
+    active_block.used += record_size;
+
+    pthread_mutex_unlock(&file_mtx);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/// @brief Compresses (if requested) and writes the oldest sealed block, then adds it
+/// to the block index and its marks to the sidecar index. Must be called from the
+/// writer thread, holding file_mtx.
+/////////////////////////////////////////////////////////////////////////////////////
+static void SeverityLogFileWriteSealed(void)
+{
+    SVRTY_FILE_PENDING_BLOCK block = sealed_queue.blocks[sealed_queue.head];
+
+    // Loggers do not touch a sealed block until it is dequeued.
+    pthread_mutex_unlock(&file_mtx);
+
+    SVRTY_FILE_BLOCK header = {0};
+
+    header.magic            = SVRTY_FILE_BLOCK_MAGIC        ;
+    header.record_amount    = block.record_amount           ;
+    header.raw_length       = (uint32_t)block.used          ;
+    header.stored_length    = (uint32_t)block.used          ;
+    header.first_ns         = block.first_ns                ;
+    header.last_ns          = block.last_ns                 ;
+
+    const uint8_t* stored = block.data;
+
+    if(file_compression == SVRTY_LOG_FILE_COMPRESSION_LZ)
+    {
+        size_t compressed_len = SeverityLogLzCompress(block.data, block.used, stored_block, SVRTY_LZ_BOUND(file_block_size));
+
+        // Blocks that do not shrink are stored as they are (stored_length == raw_length).
+        if(compressed_len > 0 && compressed_len < block.used)
+        {
+            stored                  = stored_block;
+            header.stored_length    = (uint32_t)compressed_len;
+        }
+    }
+
+    SVRTY_FILE_INDEX_ENTRY entry = {file_offset, block.first_ns, block.last_ns, block.record_amount, 0};
+
+    bool block_written = (  SeverityLogFileWriteAll(file_fd, &header, sizeof(header)) == SVRTY_FILE_SUCCESS &&
+                            SeverityLogFileWriteAll(file_fd, stored, header.stored_length) == SVRTY_FILE_SUCCESS);
+
+    if(!block_written)
+        file_index_valid = false;
+
+    // Sidecar entries are written once their block is, so they never point past the end of the file.
+    if(block_written && sidecar_fd >= 0 && block.mark_amount > 0)
+    {
+        for(uint32_t i = 0; i < block.mark_amount; i++)
+            block.marks[i].block_offset = file_offset;
+
+        SeverityLogFileWriteAll(sidecar_fd, block.marks, block.mark_amount * sizeof(SVRTY_FILE_SIDECAR_ENTRY));
+    }
+
+    file_offset += sizeof(header) + header.stored_length;
+
+    if(file_index_amount == file_index_capacity)
+    {
+        uint32_t new_capacity = (file_index_capacity == 0 ? SVRTY_FILE_INDEX_MIN_CAPACITY : file_index_capacity * 2);
+        SVRTY_FILE_INDEX_ENTRY* new_index = (SVRTY_FILE_INDEX_ENTRY*)realloc(file_index, new_capacity * sizeof(SVRTY_FILE_INDEX_ENTRY));
+
+        if(new_index != NULL)
+        {
+            file_index          = new_index;
+            file_index_capacity = new_capacity;
+        }
+    }
+
+    // If the index could not grow, readers rebuild it by walking every block.
+    if(file_index_amount < file_index_capacity)
+        file_index[file_index_amount++] = entry;
+    else
+        file_index_valid = false;
+
+    pthread_mutex_lock(&file_mtx);
+
+    // The queue may have grown meanwhile, which leaves the block just written at head anyway.
+    sealed_queue.head = (sealed_queue.head + 1) % sealed_queue.capacity;
+    --sealed_queue.amount;
+
+    pthread_cond_broadcast(&file_written_cond);
+}
+
+/////////////////////////////////////////////////////////////////////////
+/// @brief Writer thread. Writes blocks as soon as they are full, and the
+/// partially filled one periodically (or when requested).
+/////////////////////////////////////////////////////////////////////////
+static void* SeverityLogFileWriter(void* arg)
+{
+    bool timed_out = false;
+
+    pthread_mutex_lock(&file_mtx);
+
+    while(true)
+    {
+        uint64_t flush_ticket   = flush_requested;
+        bool draining           = (file_writer_stop || flush_ticket != flush_done || timed_out);
+
+        // Sealed blocks always go first, as they are older than the active one.
+        while(sealed_queue.amount > 0)
+            SeverityLogFileWriteSealed();
+
+        if(draining && active_block.record_amount > 0)
+        {
+            SeverityLogFileSeal();
+            SeverityLogFileWriteSealed();
+        }
+
+        if(flush_ticket > flush_done)
+        {
+            flush_done = flush_ticket;
+            pthread_cond_broadcast(&file_written_cond);
+        }
+
+        if(file_writer_stop && sealed_queue.amount == 0)
+            break;
+
+        if(sealed_queue.amount > 0 || flush_requested != flush_done)
+        {
+            timed_out = false;
+            continue;
+        }
+
+        struct timespec wake_time;
+
+        clock_gettime(CLOCK_REALTIME, &wake_time);
+
+        wake_time.tv_nsec += SVRTY_FILE_PERIOD_NS % SVRTY_FILE_NS_PER_SEC;
+        wake_time.tv_sec  += SVRTY_FILE_PERIOD_NS / SVRTY_FILE_NS_PER_SEC + wake_time.tv_nsec / SVRTY_FILE_NS_PER_SEC;
+        wake_time.tv_nsec %= SVRTY_FILE_NS_PER_SEC;
+
+        timed_out = (pthread_cond_timedwait(&file_writer_cond, &file_mtx, &wake_time) == ETIMEDOUT);
+    }
+
+    pthread_mutex_unlock(&file_mtx);
+
+    return NULL;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// @brief Waits until every record appended so far has been written to disk.
+/////////////////////////////////////////////////////////////////////////////
+void SeverityLogFileFlush(void)
+{
+    pthread_mutex_lock(&file_mtx);
+
+    if(!file_open)
+    {
+        pthread_mutex_unlock(&file_mtx);
+        return;
+    }
+
+    uint64_t flush_ticket = ++flush_requested;
+
+    pthread_cond_signal(&file_writer_cond);
+
+    while(file_open && flush_done < flush_ticket)
+        pthread_cond_wait(&file_written_cond, &file_mtx);
+
+    pthread_mutex_unlock(&file_mtx);
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+/// @brief Writes every pending record and the block index, then closes the file.
+/////////////////////////////////////////////////////////////////////////////////
+void SeverityLogFileClose(void)
+{
+    pthread_mutex_lock(&file_mtx);
+
+    if(!file_open)
+    {
+        pthread_mutex_unlock(&file_mtx);
+        return;
+    }
+
+    // No records are appended from now on.
+    file_open           = false;
+    file_writer_stop    = true;
+
+    pthread_cond_signal(&file_writer_cond);
+    pthread_cond_broadcast(&file_written_cond);
+
+    pthread_mutex_unlock(&file_mtx);
+
+    pthread_join(file_writer, NULL);
+
+    pthread_mutex_lock(&file_mtx);
+
+    if(file_index_valid)
+    {
+        SVRTY_FILE_TRAILER trailer = {file_offset, file_index_amount, SVRTY_FILE_TRAILER_MAGIC};
+
+        SeverityLogFileWriteAll(file_fd, file_index, file_index_amount * sizeof(SVRTY_FILE_INDEX_ENTRY));
+        SeverityLogFileWriteAll(file_fd, &trailer, sizeof(trailer));
+    }
+
+    close(file_fd);
+    file_fd = -1;
+
+    SeverityLogFileFree();
+
+    pthread_mutex_unlock(&file_mtx);
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// @brief Gets the number of records dropped because the writer thread fell
+/// too far behind (see SeverityLogFileAppend), since the file was opened.
+/// @return Number of dropped records.
+////////////////////////////////////////////////////////////////////////////
+uint64_t SeverityLogFileDropped(void)
+{
+    return __atomic_load_n(&file_dropped, __ATOMIC_RELAXED);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @brief Closes the file without writing anything, as the writer thread does
+/// not exist anymore. Meant to be used by child processes, after fork.
+//////////////////////////////////////////////////////////////////////////////
+void SeverityLogFileRelease(void)
+{
+    // Parent's writer thread may have been waiting on these when fork took place (file_mtx is
+    // not held by anyone, see SeverityLogFileLock).
+    pthread_cond_init(&file_writer_cond, NULL);
+    pthread_cond_init(&file_written_cond, NULL);
+
+    if(!file_open)
+        return;
+
+    file_open = false;
+
+    close(file_fd);
+    file_fd = -1;
+
+    SeverityLogFileFree();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @brief Takes the file sink mutex, so that fork does not take place while
+/// another thread holds it. Released by SeverityLogFileUnlock (in both parent
+/// and child processes).
+//////////////////////////////////////////////////////////////////////////////
+void SeverityLogFileLock(void)
+{
+    pthread_mutex_lock(&file_mtx);
+}
+
+///////////////////////////////////////////////////////////
+/// @brief Releases the mutex taken by SeverityLogFileLock.
+///////////////////////////////////////////////////////////
+void SeverityLogFileUnlock(void)
+{
+    pthread_mutex_unlock(&file_mtx);
+}
+
+/////////////////////////////////////////////////////////////////////////
+/// @brief Adds an entry to a reader's block index, growing it if needed.
+/// @param reader Target reader.
+/// @param capacity Current index capacity (updated if the index grows).
+/// @param entry Entry to be added.
+/// @return 0 if succeeded, < 0 otherwise.
+/////////////////////////////////////////////////////////////////////////
+static int SeverityLogFileReaderAddBlock(SVRTY_FILE_READER* reader, uint32_t* capacity, const SVRTY_FILE_INDEX_ENTRY* entry)
+{
+    if(reader->block_amount == *capacity)
+    {
+        uint32_t new_capacity = (*capacity == 0 ? SVRTY_FILE_INDEX_MIN_CAPACITY : *capacity * 2);
+
+        SVRTY_FILE_INDEX_ENTRY* new_index = (SVRTY_FILE_INDEX_ENTRY*)realloc(reader->index, new_capacity * sizeof(SVRTY_FILE_INDEX_ENTRY));
+
+        if(new_index == NULL)
+            return SVRTY_FILE_OPEN_ERR;
+
+        reader->index   = new_index;
+        *capacity       = new_capacity;
+    }
+
+    reader->index[reader->block_amount++] = *entry;
+
+    return SVRTY_FILE_SUCCESS;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/// @brief Rebuilds the block index of a file that was not properly closed. Blocks
+/// listed in its sidecar index (if any) are taken from there, and the remaining
+/// ones are found by walking them.
+/// @param reader Target reader.
+/// @param path File path.
+/// @param file_size File size.
+/// @return 0 if succeeded, < 0 otherwise.
+//////////////////////////////////////////////////////////////////////////////////
+static int SeverityLogFileReaderRebuildIndex(SVRTY_FILE_READER* reader, const char* path, const uint64_t file_size)
+{
+    uint64_t offset     = sizeof(SVRTY_FILE_HEADER);
+    uint32_t capacity   = 0;
+
+    SVRTY_FILE_SIDECAR sidecar;
+
+    if(SeverityLogFileSidecarOpen(&sidecar, path) == SVRTY_FILE_SUCCESS)
+    {
+        for(uint32_t i = 0; i < sidecar.entry_amount; i++)
+        {
+            const SVRTY_FILE_SIDECAR_ENTRY* mark = &sidecar.entries[i];
+            SVRTY_FILE_INDEX_ENTRY* last = (reader->block_amount > 0 ? &reader->index[reader->block_amount - 1] : NULL);
+
+            if(last != NULL && mark->block_offset == last->offset)
+            {
+                last->record_amount += mark->record_amount;
+                continue;
+            }
+
+            if(mark->block_offset < offset || mark->block_offset >= file_size)
+                break;
+
+            // Sidecar entries only hold span start times, so the next block's first one bounds the current block.
+            if(last != NULL)
+                last->last_ns = mark->timestamp_ns;
+
+            SVRTY_FILE_INDEX_ENTRY entry = {mark->block_offset, mark->timestamp_ns, mark->timestamp_ns, mark->record_amount, 0};
+
+            if(SeverityLogFileReaderAddBlock(reader, &capacity, &entry) < 0)
+            {
+                SeverityLogFileSidecarClose(&sidecar);
+                return SVRTY_FILE_OPEN_ERR;
+            }
+
+            offset = mark->block_offset + sizeof(SVRTY_FILE_BLOCK);
+        }
+
+        SeverityLogFileSidecarClose(&sidecar);
+
+        // Last listed block is walked again, so that its own header tells where the next one begins.
+        if(reader->block_amount > 0)
+            offset = reader->index[--reader->block_amount].offset;
+    }
+
+    while(offset + sizeof(SVRTY_FILE_BLOCK) <= file_size)
+    {
+        SVRTY_FILE_BLOCK block;
+
+        if(pread(reader->fd, &block, sizeof(block), (off_t)offset) != (ssize_t)sizeof(block))
+            break;
+
+        // Last block may have been partially written.
+        if(block.magic != SVRTY_FILE_BLOCK_MAGIC || offset + sizeof(block) + block.stored_length > file_size)
+            break;
+
+        SVRTY_FILE_INDEX_ENTRY entry = {offset, block.first_ns, block.last_ns, block.record_amount, 0};
+
+        if(SeverityLogFileReaderAddBlock(reader, &capacity, &entry) < 0)
+            return SVRTY_FILE_OPEN_ERR;
+
+        offset += sizeof(block) + block.stored_length;
+    }
+
+    return SVRTY_FILE_SUCCESS;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Opens a log file for reading. Its block index is loaded from the end of the file.
+/// If the file was not properly closed (it may still be being written), the index is rebuilt
+/// from the sidecar index if there is one, and by walking blocks otherwise.
+/// @param reader Target reader.
+/// @param path File path (as provided to SetSeverityLogFileSink).
+/// @return 0 if succeeded, < 0 otherwise.
+/////////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogFileReaderOpen(SVRTY_FILE_READER* reader, const char* path)
+{
+    memset(reader, 0, sizeof(*reader));
+
+    reader->fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if(reader->fd < 0)
+        return SVRTY_FILE_OPEN_ERR;
+
+    struct stat file_stat;
+
+    if( fstat(reader->fd, &file_stat) < 0 ||
+        pread(reader->fd, &reader->header, sizeof(reader->header), 0) != (ssize_t)sizeof(reader->header))
+    {
+        SeverityLogFileReaderClose(reader);
+        return SVRTY_FILE_OPEN_ERR;
+    }
+
+    if( reader->header.magic != SVRTY_FILE_MAGIC                ||
+        reader->header.version != SVRTY_FILE_VERSION            ||
+        reader->header.block_size > SVRTY_FILE_MAX_BLOCK_SIZE   )
+    {
+        SeverityLogFileReaderClose(reader);
+        return SVRTY_FILE_LAYOUT_ERR;
+    }
+
+    uint64_t file_size = (uint64_t)file_stat.st_size;
+
+    SVRTY_FILE_TRAILER trailer = {0};
+
+    if(file_size >= sizeof(SVRTY_FILE_HEADER) + sizeof(trailer))
+        if(pread(reader->fd, &trailer, sizeof(trailer), (off_t)(file_size - sizeof(trailer))) != (ssize_t)sizeof(trailer))
+            trailer.magic = 0;
+
+    uint64_t index_size = (uint64_t)trailer.block_amount * sizeof(SVRTY_FILE_INDEX_ENTRY);
+
+    bool trailer_valid = (  trailer.magic == SVRTY_FILE_TRAILER_MAGIC   &&
+                            trailer.index_offset + index_size + sizeof(trailer) == file_size);
+
+    if(trailer_valid && trailer.block_amount > 0)
+    {
+        reader->index = (SVRTY_FILE_INDEX_ENTRY*)malloc(index_size);
+
+        trailer_valid = (reader->index != NULL && pread(reader->fd, reader->index, index_size, (off_t)trailer.index_offset) == (ssize_t)index_size);
+    }
+
+    if(trailer_valid)
+        reader->block_amount = trailer.block_amount;
+    else
+        reader->block_amount = 0;
+
+    if(!trailer_valid && SeverityLogFileReaderRebuildIndex(reader, path, file_size) < 0)
+    {
+        SeverityLogFileReaderClose(reader);
+        return SVRTY_FILE_OPEN_ERR;
+    }
+
+    reader->stored  = (uint8_t*)malloc(SVRTY_LZ_BOUND(reader->header.block_size));
+    reader->raw     = (uint8_t*)malloc(reader->header.block_size);
+
+    if(reader->stored == NULL || reader->raw == NULL)
+    {
+        SeverityLogFileReaderClose(reader);
+        return SVRTY_FILE_OPEN_ERR;
+    }
+
+    return SVRTY_FILE_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+/// @brief Finds the first block that may hold records logged at (or after) a given
+/// time, by binary searching the block index.
+/// @param reader Target reader.
+/// @param timestamp_ns Target time (CLOCK_REALTIME, in nanoseconds).
+/// @return Block number, block_amount if every block is older.
+///////////////////////////////////////////////////////////////////////////////////
+uint32_t SeverityLogFileReaderFind(const SVRTY_FILE_READER* reader, const uint64_t timestamp_ns)
+{
+    uint32_t low    = 0;
+    uint32_t high   = reader->block_amount;
+
+    while(low < high)
+    {
+        uint32_t middle = low + (high - low) / 2;
+
+        if(reader->index[middle].last_ns < timestamp_ns)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// @brief Reads (and decompresses) a single block. Records are valid until the
+/// next block is read.
+/// @param reader Target reader.
+/// @param block Block number.
+/// @param records Decompressed records (see SVRTY_FILE_RECORD).
+/// @param records_length Decompressed length.
+/// @return 0 if succeeded, < 0 otherwise.
+///////////////////////////////////////////////////////////////////////////////
+int SeverityLogFileReaderBlock(SVRTY_FILE_READER* reader, const uint32_t block, const uint8_t** records, size_t* records_length)
+{
+    if(block >= reader->block_amount)
+        return SVRTY_FILE_BLOCK_ERR;
+
+    return SeverityLogFileReaderBlockAt(reader, reader->index[block].offset, records, records_length);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// @brief Same as SeverityLogFileReaderBlock, with the block being addressed
+/// by its offset within the file (as found in sidecar index entries).
+/// @param reader Target reader.
+/// @param offset Block header offset.
+/// @param records Decompressed records (see SVRTY_FILE_RECORD).
+/// @param records_length Decompressed length.
+/// @return 0 if succeeded, < 0 otherwise.
+/////////////////////////////////////////////////////////////////////////////
+int SeverityLogFileReaderBlockAt(SVRTY_FILE_READER* reader, const uint64_t offset, const uint8_t** records, size_t* records_length)
+{
+    SVRTY_FILE_BLOCK header;
+
+    if(pread(reader->fd, &header, sizeof(header), (off_t)offset) != (ssize_t)sizeof(header))
+        return SVRTY_FILE_BLOCK_ERR;
+
+    if( header.magic != SVRTY_FILE_BLOCK_MAGIC                  ||
+        header.raw_length > reader->header.block_size           ||
+        header.stored_length > header.raw_length                )
+        return SVRTY_FILE_BLOCK_ERR;
+
+    // Blocks that did not shrink are stored as they are.
+    bool compressed = (header.stored_length < header.raw_length);
+    uint8_t* target = (compressed ? reader->stored : reader->raw);
+
+    if(pread(reader->fd, target, header.stored_length, (off_t)(offset + sizeof(header))) != (ssize_t)header.stored_length)
+        return SVRTY_FILE_BLOCK_ERR;
+
+    if(compressed && SeverityLogLzDecompress(reader->stored, header.stored_length, reader->raw, header.raw_length) < 0)
+        return SVRTY_FILE_BLOCK_ERR;
+
+    *records        = reader->raw;
+    *records_length = header.raw_length;
+
+    return SVRTY_FILE_SUCCESS;
+}
+
+////////////////////////////////////
+/// @brief Closes a log file reader.
+/// @param reader Target reader.
+////////////////////////////////////
+void SeverityLogFileReaderClose(SVRTY_FILE_READER* reader)
+{
+    if(reader->fd >= 0)
+        close(reader->fd);
+
+    free(reader->index);
+    free(reader->stored);
+    free(reader->raw);
+
+    memset(reader, 0, sizeof(*reader));
+
+    reader->fd = -1;
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// @brief Loads the sidecar index of a log file. Entries that were still
+/// being written (if the file is still open) are left out.
+/// @param sidecar Target sidecar index.
+/// @param path Log file path (SVRTY_FILE_SIDECAR_SUFFIX is appended to it).
+/// @return 0 if succeeded, < 0 otherwise.
+////////////////////////////////////////////////////////////////////////////
+int SeverityLogFileSidecarOpen(SVRTY_FILE_SIDECAR* sidecar, const char* path)
+{
+    memset(sidecar, 0, sizeof(*sidecar));
+
+    char* sidecar_path = SeverityLogFileSidecarPath(path);
+
+    if(sidecar_path == NULL)
+        return SVRTY_FILE_OPEN_ERR;
+
+    int fd = open(sidecar_path, O_RDONLY | O_CLOEXEC);
+
+    free(sidecar_path);
+
+    if(fd < 0)
+        return SVRTY_FILE_OPEN_ERR;
+
+    struct stat file_stat;
+
+    if( fstat(fd, &file_stat) < 0 ||
+        pread(fd, &sidecar->header, sizeof(sidecar->header), 0) != (ssize_t)sizeof(sidecar->header))
+    {
+        close(fd);
+        return SVRTY_FILE_OPEN_ERR;
+    }
+
+    if(sidecar->header.magic != SVRTY_FILE_SIDECAR_MAGIC || sidecar->header.version != SVRTY_FILE_SIDECAR_VERSION)
+    {
+        close(fd);
+        return SVRTY_FILE_LAYOUT_ERR;
+    }
+
+    // A partially written entry at the end of the file is ignored.
+    uint64_t entries_size = ((uint64_t)file_stat.st_size - sizeof(sidecar->header)) / sizeof(SVRTY_FILE_SIDECAR_ENTRY) * sizeof(SVRTY_FILE_SIDECAR_ENTRY);
+
+    if(entries_size > 0)
+    {
+        sidecar->entries = (SVRTY_FILE_SIDECAR_ENTRY*)malloc(entries_size);
+
+        if(sidecar->entries == NULL || pread(fd, sidecar->entries, entries_size, sizeof(sidecar->header)) != (ssize_t)entries_size)
+        {
+            close(fd);
+            SeverityLogFileSidecarClose(sidecar);
+            return SVRTY_FILE_OPEN_ERR;
+        }
+    }
+
+    sidecar->entry_amount = (uint32_t)(entries_size / sizeof(SVRTY_FILE_SIDECAR_ENTRY));
+
+    close(fd);
+
+    return SVRTY_FILE_SUCCESS;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/// @brief Finds the entry whose span holds a given time (the last one starting at or
+/// before it), by binary searching the sidecar index.
+/// @param sidecar Target sidecar index.
+/// @param timestamp_ns Target time (CLOCK_REALTIME, in nanoseconds).
+/// @return Entry number (0 if every entry is newer), entry_amount if there are none.
+/////////////////////////////////////////////////////////////////////////////////////
+uint32_t SeverityLogFileSidecarFind(const SVRTY_FILE_SIDECAR* sidecar, const uint64_t timestamp_ns)
+{
+    uint32_t low    = 0;
+    uint32_t high   = sidecar->entry_amount;
+
+    while(low < high)
+    {
+        uint32_t middle = low + (high - low) / 2;
+
+        if(sidecar->entries[middle].timestamp_ns <= timestamp_ns)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return (low > 0 ? low - 1 : 0);
+}
+
+////////////////////////////////////////
+/// @brief Frees a sidecar index.
+/// @param sidecar Target sidecar index.
+////////////////////////////////////////
+void SeverityLogFileSidecarClose(SVRTY_FILE_SIDECAR* sidecar)
+{
+    free(sidecar->entries);
+
+    memset(sidecar, 0, sizeof(*sidecar));
+}
+
+/*************************************/
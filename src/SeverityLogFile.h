@@ -0,0 +1,88 @@
+#ifndef SEVERITY_LOG_FILE_H
+#define SEVERITY_LOG_FILE_H
+
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/uio.h>
+
+/************************************/
+
+/*************************************/
+/******** Function prototypes ********/
+/*************************************/
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Creates (or truncates) a log file and starts the writer thread that compresses
+/// and writes its blocks.
+/// @param path File path.
+/// @param compression SVRTY_LOG_FILE_COMPRESSION_NONE or SVRTY_LOG_FILE_COMPRESSION_LZ.
+/// @param block_size Maximum raw block length (0 sets the default one).
+/// @param index_records Sidecar index entry every index_records records (0: no limit).
+/// @param index_bytes Sidecar index entry every index_bytes raw bytes (0: no limit).
+/// No sidecar index is written if both are 0.
+/// @return 0 if succeeded, < 0 otherwise.
+/////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogFileOpen(const char* path, const uint8_t compression, const size_t block_size, const uint32_t index_records, const uint32_t index_bytes);
+
+////////////////////////////////////////////
+/// @brief Tells whether a log file is open.
+/// @return true if open, false otherwise.
+////////////////////////////////////////////
+bool SeverityLogFileIsOpen(void);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Appends a record to the current block. Once full, the block is queued for the
+/// writer thread. Callers never wait for it (they hold the output mutex): if the writer
+/// falls behind, droppable records are dropped and counted, while the rest are chained in
+/// further blocks until it catches up.
+/// @param severity Severity level.
+/// @param timestamp_ns CLOCK_REALTIME timestamp, in nanoseconds.
+/// @param segments Line segments (prefix and payload), concatenated into a single line.
+/// @param segment_amount Number of segments.
+/// @param droppable true if the record may be dropped while the writer is behind.
+//////////////////////////////////////////////////////////////////////////////////////////
+void SeverityLogFileAppend(const uint8_t severity, const uint64_t timestamp_ns, const struct iovec* segments, const int segment_amount, const bool droppable);
+
+////////////////////////////////////////////////////////////////////////////
+/// @brief Gets the number of records dropped because the writer thread fell
+/// too far behind (see SeverityLogFileAppend), since the file was opened.
+/// @return Number of dropped records.
+////////////////////////////////////////////////////////////////////////////
+uint64_t SeverityLogFileDropped(void);
+
+/////////////////////////////////////////////////////////////////////////////
+/// @brief Waits until every record appended so far has been written to disk.
+/////////////////////////////////////////////////////////////////////////////
+void SeverityLogFileFlush(void);
+
+/////////////////////////////////////////////////////////////////////////////////
+/// @brief Writes every pending record and the block index, then closes the file.
+/////////////////////////////////////////////////////////////////////////////////
+void SeverityLogFileClose(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @brief Closes the file without writing anything, as the writer thread does
+/// not exist anymore. Meant to be used by child processes, after fork.
+//////////////////////////////////////////////////////////////////////////////
+void SeverityLogFileRelease(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @brief Takes the file sink mutex, so that fork does not take place while
+/// another thread holds it. Released by SeverityLogFileUnlock (in both parent
+/// and child processes).
+//////////////////////////////////////////////////////////////////////////////
+void SeverityLogFileLock(void);
+
+///////////////////////////////////////////////////////////
+/// @brief Releases the mutex taken by SeverityLogFileLock.
+///////////////////////////////////////////////////////////
+void SeverityLogFileUnlock(void);
+
+/*************************************/
+
+#endif
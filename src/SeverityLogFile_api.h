@@ -0,0 +1,238 @@
+#ifndef SEVERITY_LOG_FILE_API_H
+#define SEVERITY_LOG_FILE_API_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "SeverityLog_api.h"
+
+/************************************/
+
+/***********************************/
+/******** Define statements ********/
+/***********************************/
+
+// Log file layout (every field is stored in native byte order):
+//
+//  offset 0        SVRTY_FILE_HEADER (32 bytes).
+//  offset 32       Blocks, each made of a SVRTY_FILE_BLOCK header followed by stored_length bytes.
+//                  Once decompressed, a block holds raw_length bytes of records: a SVRTY_FILE_RECORD
+//                  header followed by the line itself (not null-terminated), padded to a multiple of 8.
+//  (on close)      Block index: block_amount SVRTY_FILE_INDEX_ENTRY entries, followed by a
+//                  SVRTY_FILE_TRAILER. If the file was not properly closed, blocks can still be
+//                  found by walking them from the beginning of the file.
+//
+// Every block is compressed on its own, so any of them can be decompressed without reading the rest.
+//
+// Sidecar index (<path>.idx, only written if enabled through SetSeverityLogFileSidecarIndex):
+//
+//  offset 0        SVRTY_FILE_SIDECAR_HEADER (16 bytes).
+//  offset 16       SVRTY_FILE_SIDECAR_ENTRY entries (24 bytes each), appended as soon as their block is
+//                  written. Every entry marks a span of records within a single block: a new one starts
+//                  with every block, and every record_interval records or byte_interval bytes within it.
+
+#define SVRTY_FILE_MAGIC            0x464C5653  // "SVLF"
+#define SVRTY_FILE_BLOCK_MAGIC      0x424C5653  // "SVLB"
+#define SVRTY_FILE_TRAILER_MAGIC    0x494C5653  // "SVLI"
+#define SVRTY_FILE_VERSION          1
+#define SVRTY_FILE_SIDECAR_MAGIC    0x584C5653  // "SVLX"
+#define SVRTY_FILE_SIDECAR_VERSION  1
+#define SVRTY_FILE_SIDECAR_SUFFIX   ".idx"
+
+#define SVRTY_FILE_SEVERITY_BIT(SEVERITY)   (1U << (SEVERITY))  // Sidecar entry severity_mask bit.
+
+#define SVRTY_FILE_RECORD_ALIGNMENT 8
+#define SVRTY_FILE_RECORD_SIZE(LENGTH)  ((sizeof(SVRTY_FILE_RECORD) + (LENGTH) + SVRTY_FILE_RECORD_ALIGNMENT - 1) & ~((size_t)SVRTY_FILE_RECORD_ALIGNMENT - 1))
+
+#define SVRTY_FILE_SUCCESS      0
+#define SVRTY_FILE_OPEN_ERR     -1  // File could not be opened or read.
+#define SVRTY_FILE_LAYOUT_ERR   -2  // File is not a SeverityLog file (or version mismatch).
+#define SVRTY_FILE_BLOCK_ERR    -3  // Block does not exist, or it is corrupted.
+
+/***********************************/
+
+/**********************************/
+/******** Type definitions ********/
+/**********************************/
+
+/// @brief File header, placed at the beginning of the file.
+typedef struct
+{
+    uint32_t    magic           ;   // SVRTY_FILE_MAGIC.
+    uint16_t    version         ;   // SVRTY_FILE_VERSION.
+    uint16_t    compression     ;   // SVRTY_LOG_FILE_COMPRESSION_NONE or SVRTY_LOG_FILE_COMPRESSION_LZ.
+    uint32_t    block_size      ;   // Maximum raw (decompressed) block length.
+    uint8_t     reserved[20]    ;
+} SVRTY_FILE_HEADER;
+
+/// @brief Block header, placed right before every block.
+typedef struct
+{
+    uint32_t    magic           ;   // SVRTY_FILE_BLOCK_MAGIC.
+    uint32_t    record_amount   ;   // Number of records in the block.
+    uint32_t    raw_length      ;   // Decompressed length.
+    uint32_t    stored_length   ;   // Length in the file. Equal to raw_length if the block is not compressed.
+    uint64_t    first_ns        ;   // First record's timestamp (CLOCK_REALTIME, in nanoseconds).
+    uint64_t    last_ns         ;   // Last record's timestamp.
+} SVRTY_FILE_BLOCK;
+
+/// @brief Record header, placed at the beginning of every record (within a decompressed block).
+typedef struct
+{
+    uint64_t    timestamp_ns    ;   // CLOCK_REALTIME, in nanoseconds.
+    uint32_t    length          ;   // Line length (prefix included, no line feed).
+    uint8_t     severity        ;   // SVRTY_LVL_ERR, SVRTY_LVL_INF, SVRTY_LVL_WNG or SVRTY_LVL_DBG.
+    uint8_t     reserved[3]     ;
+    char        line[]          ;   // Line as printed to stdout, without colors.
+} SVRTY_FILE_RECORD;
+
+/// @brief Block index entry.
+typedef struct
+{
+    uint64_t    offset          ;   // Block header offset within the file.
+    uint64_t    first_ns        ;   // Same as the block header's.
+    uint64_t    last_ns         ;   // Same as the block header's.
+    uint32_t    record_amount   ;   // Same as the block header's.
+    uint32_t    reserved        ;
+} SVRTY_FILE_INDEX_ENTRY;
+
+/// @brief File trailer, placed at the end of a properly closed file.
+typedef struct
+{
+    uint64_t    index_offset    ;   // Offset of the first index entry.
+    uint32_t    block_amount    ;   // Number of index entries.
+    uint32_t    magic           ;   // SVRTY_FILE_TRAILER_MAGIC.
+} SVRTY_FILE_TRAILER;
+
+/// @brief Sidecar index header, placed at the beginning of the sidecar file.
+typedef struct
+{
+    uint32_t    magic           ;   // SVRTY_FILE_SIDECAR_MAGIC.
+    uint16_t    version         ;   // SVRTY_FILE_SIDECAR_VERSION.
+    uint16_t    reserved        ;
+    uint32_t    record_interval ;   // Maximum number of records per entry (0 if not limited).
+    uint32_t    byte_interval   ;   // Maximum raw bytes per entry (0 if not limited).
+} SVRTY_FILE_SIDECAR_HEADER;
+
+/// @brief Sidecar index entry, which marks a span of records within a block.
+typedef struct
+{
+    uint64_t    timestamp_ns    ;   // First record's timestamp.
+    uint64_t    block_offset    ;   // Block header offset within the log file.
+    uint32_t    record_offset   ;   // First record's offset within the decompressed block.
+    uint16_t    record_amount   ;   // Number of records in the span.
+    uint8_t     severity_mask   ;   // Severity levels found in the span (see SVRTY_FILE_SEVERITY_BIT).
+    uint8_t     reserved        ;
+} SVRTY_FILE_SIDECAR_ENTRY;
+
+/// @brief Sidecar index, as loaded by SeverityLogFileSidecarOpen.
+typedef struct
+{
+    SVRTY_FILE_SIDECAR_HEADER   header          ;   // Sidecar header.
+    SVRTY_FILE_SIDECAR_ENTRY*   entries         ;   // Every entry, sorted by file position.
+    uint32_t                    entry_amount    ;   // Number of entries.
+} SVRTY_FILE_SIDECAR;
+
+/// @brief File reader. Only meant to be handled by SeverityLogFileReader* functions.
+typedef struct
+{
+    int                     fd              ;   // Target file.
+    SVRTY_FILE_HEADER       header          ;   // File header.
+    SVRTY_FILE_INDEX_ENTRY* index           ;   // Block index (read from the file, or rebuilt).
+    uint32_t                block_amount    ;   // Number of blocks.
+    uint8_t*                stored          ;   // Block, as read from the file.
+    uint8_t*                raw             ;   // Block, once decompressed.
+} SVRTY_FILE_READER;
+
+/**********************************/
+
+/*************************************/
+/******** Function prototypes ********/
+/*************************************/
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Opens a log file for reading. Its block index is loaded from the end of the file.
+/// If the file was not properly closed (it may still be being written), the index is rebuilt
+/// from the sidecar index if there is one, and by walking blocks otherwise.
+/// @param reader Target reader.
+/// @param path File path (as provided to SetSeverityLogFileSink).
+/// @return 0 if succeeded, < 0 otherwise.
+/////////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SeverityLogFileReaderOpen(SVRTY_FILE_READER* reader, const char* path);
+
+///////////////////////////////////////////////////////////////////////////////////
+/// @brief Finds the first block that may hold records logged at (or after) a given
+/// time, by binary searching the block index.
+/// @param reader Target reader.
+/// @param timestamp_ns Target time (CLOCK_REALTIME, in nanoseconds).
+/// @return Block number, block_amount if every block is older.
+///////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API uint32_t SeverityLogFileReaderFind(const SVRTY_FILE_READER* reader, const uint64_t timestamp_ns);
+
+///////////////////////////////////////////////////////////////////////////////
+/// @brief Reads (and decompresses) a single block. Records are valid until the
+/// next block is read.
+/// @param reader Target reader.
+/// @param block Block number.
+/// @param records Decompressed records (see SVRTY_FILE_RECORD).
+/// @param records_length Decompressed length.
+/// @return 0 if succeeded, < 0 otherwise.
+///////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SeverityLogFileReaderBlock(SVRTY_FILE_READER* reader, const uint32_t block, const uint8_t** records, size_t* records_length);
+
+/////////////////////////////////////////////////////////////////////////////
+/// @brief Same as SeverityLogFileReaderBlock, with the block being addressed
+/// by its offset within the file (as found in sidecar index entries).
+/// @param reader Target reader.
+/// @param offset Block header offset.
+/// @param records Decompressed records (see SVRTY_FILE_RECORD).
+/// @param records_length Decompressed length.
+/// @return 0 if succeeded, < 0 otherwise.
+/////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SeverityLogFileReaderBlockAt(SVRTY_FILE_READER* reader, const uint64_t offset, const uint8_t** records, size_t* records_length);
+
+////////////////////////////////////
+/// @brief Closes a log file reader.
+/// @param reader Target reader.
+////////////////////////////////////
+C_SEVERITY_LOG_API void SeverityLogFileReaderClose(SVRTY_FILE_READER* reader);
+
+////////////////////////////////////////////////////////////////////////////
+/// @brief Loads the sidecar index of a log file. Entries that were still
+/// being written (if the file is still open) are left out.
+/// @param sidecar Target sidecar index.
+/// @param path Log file path (SVRTY_FILE_SIDECAR_SUFFIX is appended to it).
+/// @return 0 if succeeded, < 0 otherwise.
+////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SeverityLogFileSidecarOpen(SVRTY_FILE_SIDECAR* sidecar, const char* path);
+
+/////////////////////////////////////////////////////////////////////////////////////
+/// @brief Finds the entry whose span holds a given time (the last one starting at or
+/// before it), by binary searching the sidecar index.
+/// @param sidecar Target sidecar index.
+/// @param timestamp_ns Target time (CLOCK_REALTIME, in nanoseconds).
+/// @return Entry number (0 if every entry is newer), entry_amount if there are none.
+/////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API uint32_t SeverityLogFileSidecarFind(const SVRTY_FILE_SIDECAR* sidecar, const uint64_t timestamp_ns);
+
+////////////////////////////////////////
+/// @brief Frees a sidecar index.
+/// @param sidecar Target sidecar index.
+////////////////////////////////////////
+C_SEVERITY_LOG_API void SeverityLogFileSidecarClose(SVRTY_FILE_SIDECAR* sidecar);
+
+/*************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,263 @@
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "SeverityLogLz.h"
+
+/************************************/
+
+/***********************************/
+/******** Define statements ********/
+/***********************************/
+
+// Block format (LZ77, byte oriented): a sequence of (token, [literal length bytes], literals,
+// offset, [match length bytes]) entries. Token's high nibble holds the literal length and its low
+// nibble the match length minus SVRTY_LZ_MIN_MATCH. 15 means the length continues in the next
+// bytes (added up until a byte other than 255 is found). Offsets take 2 bytes (little endian).
+// The last sequence only holds literals, and ends the block.
+
+#define SVRTY_LZ_HASH_BITS      12
+#define SVRTY_LZ_HASH_SIZE      (1 << SVRTY_LZ_HASH_BITS)
+#define SVRTY_LZ_HASH_PRIME     2654435761U
+#define SVRTY_LZ_MIN_MATCH      4
+#define SVRTY_LZ_MAX_OFFSET     65535
+#define SVRTY_LZ_LAST_LITERALS  5   // Block tail is always stored as literals.
+#define SVRTY_LZ_MATCH_LIMIT    12  // No match starts this close to the end of the block.
+#define SVRTY_LZ_LEN_MASK       15
+#define SVRTY_LZ_LEN_EXT        255
+#define SVRTY_LZ_TOKEN_SHIFT    4
+#define SVRTY_LZ_OFFSET_SIZE    2
+
+#define SVRTY_LZ_SUCCESS        0
+#define SVRTY_LZ_CORRUPTED      -1
+
+/***********************************/
+
+/*************************************/
+/**** Private function prototypes ****/
+/*************************************/
+
+static uint32_t SeverityLogLzRead32(const uint8_t* ptr);
+static uint32_t SeverityLogLzHash(const uint32_t sequence);
+static uint8_t* SeverityLogLzWriteLength(uint8_t* op, size_t length);
+static uint8_t* SeverityLogLzWriteSequence(uint8_t* op, const uint8_t* op_end, const uint8_t* literals, const size_t literal_len, const size_t offset, const size_t match_len);
+
+/*************************************/
+
+/*************************************/
+/******* Function definitions ********/
+/*************************************/
+
+/////////////////////////////////////////////////////////
+/// @brief Reads 4 bytes, no matter how they are aligned.
+/// @param ptr Target memory.
+/// @return Read value.
+/////////////////////////////////////////////////////////
+static uint32_t SeverityLogLzRead32(const uint8_t* ptr)
+{
+    uint32_t value;
+
+    memcpy(&value, ptr, sizeof(value));
+
+    return value;
+}
+
+///////////////////////////////////////////////////////
+/// @brief Hashes a 4 byte sequence into a table index.
+/// @param sequence Target sequence.
+/// @return Table index.
+///////////////////////////////////////////////////////
+static uint32_t SeverityLogLzHash(const uint32_t sequence)
+{
+    return (sequence * SVRTY_LZ_HASH_PRIME) >> (32 - SVRTY_LZ_HASH_BITS);
+}
+
+/////////////////////////////////////////////////////////////
+/// @brief Writes the part of a length that does not fit in a
+/// token's nibble.
+/// @param op Target memory.
+/// @param length Length minus SVRTY_LZ_LEN_MASK.
+/// @return Memory right after the written bytes.
+/////////////////////////////////////////////////////////////
+static uint8_t* SeverityLogLzWriteLength(uint8_t* op, size_t length)
+{
+    while(length >= SVRTY_LZ_LEN_EXT)
+    {
+        *op++ = SVRTY_LZ_LEN_EXT;
+        length -= SVRTY_LZ_LEN_EXT;
+    }
+
+    *op++ = (uint8_t)length;
+
+    return op;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @brief Writes a sequence (literals, followed by a match if match_len > 0).
+/// @param op Target memory.
+/// @param op_end End of target memory.
+/// @param literals Literals to be copied.
+/// @param literal_len Number of literals.
+/// @param offset Match offset (distance backwards from the current position).
+/// @param match_len Match length (0 for the last sequence).
+/// @return Memory right after the written sequence, NULL if it does not fit.
+//////////////////////////////////////////////////////////////////////////////
+static uint8_t* SeverityLogLzWriteSequence(uint8_t* op, const uint8_t* op_end, const uint8_t* literals, const size_t literal_len, const size_t offset, const size_t match_len)
+{
+    size_t worst_case = 1 + (literal_len / SVRTY_LZ_LEN_EXT) + 1 + literal_len + SVRTY_LZ_OFFSET_SIZE + (match_len / SVRTY_LZ_LEN_EXT) + 1;
+
+    if(worst_case > (size_t)(op_end - op))
+        return NULL;
+
+    size_t match_code   = (match_len > 0 ? match_len - SVRTY_LZ_MIN_MATCH : 0);
+    uint8_t* token      = op++;
+
+    *token = (uint8_t)(((literal_len < SVRTY_LZ_LEN_MASK ? literal_len : SVRTY_LZ_LEN_MASK) << SVRTY_LZ_TOKEN_SHIFT) |
+                        (match_code < SVRTY_LZ_LEN_MASK ? match_code : SVRTY_LZ_LEN_MASK));
+
+    if(literal_len >= SVRTY_LZ_LEN_MASK)
+        op = SeverityLogLzWriteLength(op, literal_len - SVRTY_LZ_LEN_MASK);
+
+    memcpy(op, literals, literal_len);
+    op += literal_len;
+
+    if(match_len == 0)
+        return op;
+
+    *op++ = (uint8_t)(offset & 0xFF);
+    *op++ = (uint8_t)(offset >> 8);
+
+    if(match_code >= SVRTY_LZ_LEN_MASK)
+        op = SeverityLogLzWriteLength(op, match_code - SVRTY_LZ_LEN_MASK);
+
+    return op;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Compresses a block. Blocks are independent: no state is kept from one to another.
+/// @param src Data to be compressed.
+/// @param src_len Data length.
+/// @param dst Target memory.
+/// @param dst_capacity Target memory size.
+/// @return Compressed length, 0 if it does not fit in dst (data should be stored as it is).
+////////////////////////////////////////////////////////////////////////////////////////////
+size_t SeverityLogLzCompress(const uint8_t* src, const size_t src_len, uint8_t* dst, const size_t dst_capacity)
+{
+    uint32_t table[SVRTY_LZ_HASH_SIZE] = {0};
+
+    uint8_t* op             = dst;
+    const uint8_t* op_end   = dst + dst_capacity;
+    size_t ip               = 0;
+    size_t anchor           = 0;
+
+    if(src_len >= SVRTY_LZ_MATCH_LIMIT)
+    {
+        size_t match_start_limit    = src_len - SVRTY_LZ_MATCH_LIMIT;
+        size_t match_end_limit      = src_len - SVRTY_LZ_LAST_LITERALS;
+
+        while(ip < match_start_limit)
+        {
+            uint32_t sequence   = SeverityLogLzRead32(src + ip);
+            uint32_t hash       = SeverityLogLzHash(sequence);
+            size_t candidate    = table[hash];
+
+            table[hash] = (uint32_t)ip;
+
+            if(candidate >= ip || ip - candidate > SVRTY_LZ_MAX_OFFSET || SeverityLogLzRead32(src + candidate) != sequence)
+            {
+                ++ip;
+                continue;
+            }
+
+            size_t match_len = SVRTY_LZ_MIN_MATCH;
+
+            while(ip + match_len < match_end_limit && src[candidate + match_len] == src[ip + match_len])
+                ++match_len;
+
+            op = SeverityLogLzWriteSequence(op, op_end, src + anchor, ip - anchor, ip - candidate, match_len);
+
+            if(op == NULL)
+                return 0;
+
+            ip      += match_len;
+            anchor  = ip;
+        }
+    }
+
+    op = SeverityLogLzWriteSequence(op, op_end, src + anchor, src_len - anchor, 0, 0);
+
+    return (op == NULL ? 0 : (size_t)(op - dst));
+}
+
+////////////////////////////////////////////////////////////////////
+/// @brief Decompresses a block compressed by SeverityLogLzCompress.
+/// @param src Compressed data.
+/// @param src_len Compressed data length.
+/// @param dst Target memory.
+/// @param dst_len Expected decompressed length.
+/// @return 0 if succeeded, < 0 if the block is corrupted.
+////////////////////////////////////////////////////////////////////
+int SeverityLogLzDecompress(const uint8_t* src, const size_t src_len, uint8_t* dst, const size_t dst_len)
+{
+    const uint8_t* ip       = src;
+    const uint8_t* ip_end   = src + src_len;
+    uint8_t* op             = dst;
+    const uint8_t* op_end   = dst + dst_len;
+
+    while(ip < ip_end)
+    {
+        uint8_t token       = *ip++;
+        size_t literal_len  = token >> SVRTY_LZ_TOKEN_SHIFT;
+        size_t match_len    = token & SVRTY_LZ_LEN_MASK;
+        uint8_t extension   = SVRTY_LZ_LEN_EXT;
+
+        while(literal_len >= SVRTY_LZ_LEN_MASK && extension == SVRTY_LZ_LEN_EXT && ip < ip_end)
+        {
+            extension   = *ip++;
+            literal_len += extension;
+        }
+
+        if(literal_len > (size_t)(ip_end - ip) || literal_len > (size_t)(op_end - op))
+            return SVRTY_LZ_CORRUPTED;
+
+        memcpy(op, ip, literal_len);
+        ip += literal_len;
+        op += literal_len;
+
+        // Last sequence has no match.
+        if(ip == ip_end)
+            break;
+
+        if(ip_end - ip < SVRTY_LZ_OFFSET_SIZE)
+            return SVRTY_LZ_CORRUPTED;
+
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += SVRTY_LZ_OFFSET_SIZE;
+
+        extension = SVRTY_LZ_LEN_EXT;
+
+        while(match_len >= SVRTY_LZ_LEN_MASK && extension == SVRTY_LZ_LEN_EXT && ip < ip_end)
+        {
+            extension   = *ip++;
+            match_len   += extension;
+        }
+
+        match_len += SVRTY_LZ_MIN_MATCH;
+
+        if(offset == 0 || offset > (size_t)(op - dst) || match_len > (size_t)(op_end - op))
+            return SVRTY_LZ_CORRUPTED;
+
+        // Byte by byte, as the match may overlap the data it is copied to.
+        for(size_t i = 0; i < match_len; i++)
+            op[i] = op[i - offset];
+
+        op += match_len;
+    }
+
+    return (op == op_end ? SVRTY_LZ_SUCCESS : SVRTY_LZ_CORRUPTED);
+}
+
+/*************************************/
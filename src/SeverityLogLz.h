@@ -0,0 +1,48 @@
+#ifndef SEVERITY_LOG_LZ_H
+#define SEVERITY_LOG_LZ_H
+
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/************************************/
+
+/***********************************/
+/******** Define statements ********/
+/***********************************/
+
+// Worst case compressed size (incompressible data): literals plus one length byte every 255 of them.
+#define SVRTY_LZ_BOUND(SIZE)    ((SIZE) + ((SIZE) / 255) + 16)
+
+/***********************************/
+
+/*************************************/
+/******** Function prototypes ********/
+/*************************************/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Compresses a block. Blocks are independent: no state is kept from one to another.
+/// @param src Data to be compressed.
+/// @param src_len Data length.
+/// @param dst Target memory.
+/// @param dst_capacity Target memory size.
+/// @return Compressed length, 0 if it does not fit in dst (data should be stored as it is).
+////////////////////////////////////////////////////////////////////////////////////////////
+size_t SeverityLogLzCompress(const uint8_t* src, const size_t src_len, uint8_t* dst, const size_t dst_capacity);
+
+////////////////////////////////////////////////////////////////////
+/// @brief Decompresses a block compressed by SeverityLogLzCompress.
+/// @param src Compressed data.
+/// @param src_len Compressed data length.
+/// @param dst Target memory.
+/// @param dst_len Expected decompressed length.
+/// @return 0 if succeeded, < 0 if the block is corrupted.
+////////////////////////////////////////////////////////////////////
+int SeverityLogLzDecompress(const uint8_t* src, const size_t src_len, uint8_t* dst, const size_t dst_len);
+
+/*************************************/
+
+#endif
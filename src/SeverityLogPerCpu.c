@@ -0,0 +1,812 @@
+#define _GNU_SOURCE
+
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "SeverityLogPerCpu.h"
+
+/************************************/
+
+/***********************************/
+/******** Define statements ********/
+/***********************************/
+
+#define SVRTY_PERCPU_CACHE_LINE     64
+#define SVRTY_PERCPU_RECORD_ALIGN   8
+#define SVRTY_PERCPU_IOV_MAX        256         // Records handed to the output function at once.
+#define SVRTY_PERCPU_PERIOD_NS      10000000L   // Writer wakes up at least this often (10 ms).
+
+#define SVRTY_PERCPU_NS_PER_SEC     1000000000ULL
+
+#define SVRTY_PERCPU_ALIGN(size)    (((size) + SVRTY_PERCPU_RECORD_ALIGN - 1) & ~((size_t)SVRTY_PERCPU_RECORD_ALIGN - 1))
+
+/***********************************/
+
+/**********************************/
+/******** Type definitions ********/
+/**********************************/
+
+/// @brief Staged record header. Record content follows, padded to SVRTY_PERCPU_RECORD_ALIGN.
+typedef struct
+{
+    uint64_t    timestamp_ns    ;   // CLOCK_MONOTONIC, taken while holding the segment lock.
+    uint32_t    length          ;   // Content length.
+    uint32_t    reserved        ;
+} SVRTY_PERCPU_RECORD;
+
+/// @brief Per-CPU (and per-lane) staging area. Cache line aligned, so that CPUs do not share lines.
+typedef struct
+{
+    pthread_mutex_t lock            ;   // Only contended by threads running on the same CPU (and the writer).
+    char*           segment         ;   // Records staged by producers (mapped apart, so that its pages are first touched on its CPU).
+    size_t          used            ;   // Bytes in use within segment.
+    char*           pending         ;   // Writer-private: records collected but not output yet (1 segment long).
+    size_t          pending_used    ;   // Bytes in use within pending.
+    size_t          pending_offset  ;   // Next record to be merged within pending.
+} __attribute__((aligned(SVRTY_PERCPU_CACHE_LINE))) SVRTY_PERCPU;
+
+/**********************************/
+
+/***********************************/
+/******** Private variables ********/
+/***********************************/
+
+static pthread_mutex_t      percpu_control_mtx  = PTHREAD_MUTEX_INITIALIZER ;
+static pthread_mutex_t      writer_mtx          = PTHREAD_MUTEX_INITIALIZER ;
+static pthread_cond_t       writer_cond         = PTHREAD_COND_INITIALIZER  ;
+static pthread_cond_t       flush_cond          = PTHREAD_COND_INITIALIZER  ;
+static pthread_cond_t       space_cond          = PTHREAD_COND_INITIALIZER  ;
+static pthread_cond_t       users_cond          = PTHREAD_COND_INITIALIZER  ;
+static pthread_t            writer_thread                                   ;
+static bool                 writer_stop         = false                     ;
+static uint64_t             flush_requested     = 0                         ;
+static uint64_t             flush_done          = 0                         ;
+static uint64_t             collect_count       = 0                         ;
+static bool                 percpu_active       = false                     ;
+static bool                 percpu_exiting      = false                     ;
+static unsigned int         percpu_users        = 0                         ;
+static uint64_t             high_flush_done     = 0                         ;
+static bool                 high_lane_staged    = false                     ;
+static uint64_t             percpu_dropped      = 0                         ;
+static SVRTY_PERCPU*        percpu[SVRTY_PERCPU_LANE_AMOUNT]        = {NULL};
+static size_t*              merge_heap[SVRTY_PERCPU_LANE_AMOUNT]    = {NULL};
+static size_t               percpu_amount       = 0                         ;
+static size_t               percpu_segment_size = 0                         ;
+static SVRTY_PERCPU_OUTPUT  percpu_output       = NULL                      ;
+
+/***********************************/
+
+/*************************************/
+/**** Private function prototypes ****/
+/*************************************/
+
+static uint64_t SeverityLogPerCpuNow(void);
+static void SeverityLogPerCpuFree(void);
+static void* SeverityLogPerCpuTouch(void* arg);
+static void SeverityLogPerCpuFirstTouch(void);
+static void SeverityLogPerCpuLeave(void);
+static void SeverityLogPerCpuWakeWriter(void);
+static uint64_t SeverityLogPerCpuHeadTimestamp(const int lane, const size_t cpu);
+static void SeverityLogPerCpuHeapSiftDown(const int lane, size_t heap_size, size_t idx);
+static void SeverityLogPerCpuCollect(const int lane, const uint64_t cutoff_ns);
+static void SeverityLogPerCpuMerge(const int lane);
+static void SeverityLogPerCpuDrain(const int lane);
+static void SeverityLogPerCpuDrainHigh(void);
+static void* SeverityLogPerCpuWriter(void* arg);
+
+/*************************************/
+
+/*************************************/
+/******* Function definitions ********/
+/*************************************/
+
+////////////////////////////////////////////////////
+/// @brief Gets the timestamp records are merged by.
+/// @return CLOCK_MONOTONIC time, in nanoseconds.
+////////////////////////////////////////////////////
+static uint64_t SeverityLogPerCpuNow(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * SVRTY_PERCPU_NS_PER_SEC) + (uint64_t)now.tv_nsec;
+}
+
+/////////////////////////////////////////////////////////
+/// @brief Frees every staging area (locks not included).
+/////////////////////////////////////////////////////////
+static void SeverityLogPerCpuFree(void)
+{
+    for(int lane = 0; lane < SVRTY_PERCPU_LANE_AMOUNT; lane++)
+    {
+        for(size_t cpu = 0; percpu[lane] != NULL && cpu < percpu_amount; cpu++)
+        {
+            if(percpu[lane][cpu].segment != NULL)
+                munmap(percpu[lane][cpu].segment, percpu_segment_size);
+
+            free(percpu[lane][cpu].pending);
+        }
+
+        free(percpu[lane]);
+        free(merge_heap[lane]);
+
+        percpu[lane]        = NULL;
+        merge_heap[lane]    = NULL;
+    }
+
+    percpu_amount = 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+/// @brief Touches a CPU's segments (every lane), while running on it.
+/// @param arg Target CPU.
+/// @return NULL.
+//////////////////////////////////////////////////////////////////////
+static void* SeverityLogPerCpuTouch(void* arg)
+{
+    size_t cpu = (size_t)(uintptr_t)arg;
+
+    for(int lane = 0; lane < SVRTY_PERCPU_LANE_AMOUNT; lane++)
+        memset(percpu[lane][cpu].segment, 0, percpu_segment_size);
+
+    return NULL;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Touches every segment's pages from a short-lived helper thread pinned to the
+/// segment's CPU, so that they are placed in its NUMA node (the calling thread's affinity is
+/// left alone). Segments of CPUs helpers cannot run on (i.e. restricted by cgroups) are
+/// placed by the first producer writing into them instead.
+/////////////////////////////////////////////////////////////////////////////////////////////
+static void SeverityLogPerCpuFirstTouch(void)
+{
+    pthread_t* touchers = (pthread_t*)malloc(percpu_amount * sizeof(pthread_t));
+    bool* touching      = (bool*)calloc(percpu_amount, sizeof(bool));
+
+    for(size_t cpu = 0; touchers != NULL && touching != NULL && cpu < percpu_amount && cpu < CPU_SETSIZE; cpu++)
+    {
+        cpu_set_t touch_cpu_set;
+        CPU_ZERO(&touch_cpu_set);
+        CPU_SET(cpu, &touch_cpu_set);
+
+        pthread_attr_t touch_attr;
+        pthread_attr_init(&touch_attr);
+
+        // Fails for CPUs the process is not allowed to run on.
+        touching[cpu] = (   pthread_attr_setaffinity_np(&touch_attr, sizeof(cpu_set_t), &touch_cpu_set) == 0 &&
+                            pthread_create(&touchers[cpu], &touch_attr, SeverityLogPerCpuTouch, (void*)(uintptr_t)cpu) == 0);
+
+        pthread_attr_destroy(&touch_attr);
+    }
+
+    // Helpers run concurrently, so that large hosts are not touched one CPU at a time.
+    for(size_t cpu = 0; touchers != NULL && touching != NULL && cpu < percpu_amount; cpu++)
+        if(touching[cpu])
+            pthread_join(touchers[cpu], NULL);
+
+    free(touchers);
+    free(touching);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Allocates a staging segment per CPU and starts the writer thread that drains them.
+/// @param segment_size Size of each CPU's staging segment.
+/// @param writer_cpus CPUs the writer thread is pinned to (NULL does not pin it).
+/// @param writer_cpu_amount Number of elements in writer_cpus.
+/// @param output Function merged records are handed to.
+/// @return 0 if succeeded, < 0 otherwise (i.e. if staging was already enabled).
+/////////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogPerCpuInit(const size_t segment_size, const int* writer_cpus, const size_t writer_cpu_amount, SVRTY_PERCPU_OUTPUT output)
+{
+    pthread_mutex_lock(&percpu_control_mtx);
+
+    long cpu_amount = sysconf(_SC_NPROCESSORS_CONF);
+
+    if(percpu_active || output == NULL || segment_size <= sizeof(SVRTY_PERCPU_RECORD) || cpu_amount <= 0)
+    {
+        pthread_mutex_unlock(&percpu_control_mtx);
+        return SVRTY_PERCPU_INIT_ERR;
+    }
+
+    percpu_amount       = (size_t)cpu_amount;
+    percpu_segment_size = SVRTY_PERCPU_ALIGN(segment_size);
+    percpu_output       = output;
+
+    bool allocated = true;
+
+    for(int lane = 0; allocated && lane < SVRTY_PERCPU_LANE_AMOUNT; lane++)
+    {
+        percpu[lane]        = (SVRTY_PERCPU*)aligned_alloc(SVRTY_PERCPU_CACHE_LINE, percpu_amount * sizeof(SVRTY_PERCPU));
+        merge_heap[lane]    = (size_t*)calloc(percpu_amount, sizeof(size_t));
+
+        allocated = (percpu[lane] != NULL && merge_heap[lane] != NULL);
+
+        if(percpu[lane] != NULL)
+            memset(percpu[lane], 0, percpu_amount * sizeof(SVRTY_PERCPU));
+
+        // Segments are mapped rather than taken from the heap, so that none of their pages has been touched
+        // yet (see SeverityLogPerCpuFirstTouch). Pending buffers are first touched by the writer thread, and
+        // only ever hold what was collected from one segment (see SeverityLogPerCpuCollect).
+        for(size_t cpu = 0; allocated && cpu < percpu_amount; cpu++)
+        {
+            void* segment = mmap(NULL, percpu_segment_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+            pthread_mutex_init(&percpu[lane][cpu].lock, NULL);
+            percpu[lane][cpu].segment = (segment == MAP_FAILED ? NULL : (char*)segment);
+            percpu[lane][cpu].pending = (char*)malloc(percpu_segment_size);
+            allocated = (percpu[lane][cpu].segment != NULL && percpu[lane][cpu].pending != NULL);
+        }
+    }
+
+    if(allocated)
+        SeverityLogPerCpuFirstTouch();
+
+    pthread_attr_t writer_attr;
+    pthread_attr_init(&writer_attr);
+
+    if(allocated && writer_cpus != NULL && writer_cpu_amount > 0)
+    {
+        cpu_set_t writer_cpu_set;
+        CPU_ZERO(&writer_cpu_set);
+
+        for(size_t i = 0; i < writer_cpu_amount; i++)
+            if(writer_cpus[i] >= 0 && writer_cpus[i] < CPU_SETSIZE)
+                CPU_SET(writer_cpus[i], &writer_cpu_set);
+
+        allocated = (pthread_attr_setaffinity_np(&writer_attr, sizeof(cpu_set_t), &writer_cpu_set) == 0);
+    }
+
+    writer_stop = false;
+
+    if(!allocated || pthread_create(&writer_thread, &writer_attr, SeverityLogPerCpuWriter, NULL) != 0)
+    {
+        pthread_attr_destroy(&writer_attr);
+        SeverityLogPerCpuFree();
+        pthread_mutex_unlock(&percpu_control_mtx);
+        return SVRTY_PERCPU_INIT_ERR;
+    }
+
+    pthread_attr_destroy(&writer_attr);
+
+    __atomic_store_n(&percpu_active, true, __ATOMIC_SEQ_CST);
+
+    pthread_mutex_unlock(&percpu_control_mtx);
+
+    return SVRTY_PERCPU_SUCCESS;
+}
+
+////////////////////////////////////////////////////
+/// @brief Tells whether per-CPU staging is enabled.
+/// @return true if enabled, false otherwise.
+////////////////////////////////////////////////////
+bool SeverityLogPerCpuIsActive(void)
+{
+    // Acquire, so that percpu_exiting is seen as set if staging is found disabled (see SeverityLogPerCpuExit).
+    return __atomic_load_n(&percpu_active, __ATOMIC_ACQUIRE);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/// @brief Waits until staging is completely disabled, if it is being disabled, so
+/// that synchronous logs do not overtake records that are still being output.
+/// Returns right away otherwise.
+//////////////////////////////////////////////////////////////////////////////////
+void SeverityLogPerCpuWaitExit(void)
+{
+    if(!__atomic_load_n(&percpu_exiting, __ATOMIC_ACQUIRE))
+        return;
+
+    // Held by SeverityLogPerCpuExit until every staged record has been output.
+    pthread_mutex_lock(&percpu_control_mtx);
+    pthread_mutex_unlock(&percpu_control_mtx);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Stops counting the calling producer as a segment user, waking up the
+/// thread disabling staging (see SeverityLogPerCpuExit) if it was the last one.
+////////////////////////////////////////////////////////////////////////////////
+static void SeverityLogPerCpuLeave(void)
+{
+    if(__atomic_sub_fetch(&percpu_users, 1, __ATOMIC_SEQ_CST) > 0 || !__atomic_load_n(&percpu_exiting, __ATOMIC_SEQ_CST))
+        return;
+
+    pthread_mutex_lock(&writer_mtx);
+    pthread_cond_broadcast(&users_cond);
+    pthread_mutex_unlock(&writer_mtx);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @brief Wakes the writer up. No lock is taken: if the signal gets lost, the
+/// writer wakes up anyway once its period expires.
+//////////////////////////////////////////////////////////////////////////////
+static void SeverityLogPerCpuWakeWriter(void)
+{
+    pthread_cond_signal(&writer_cond);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Stages a record into the calling CPU's segment, timestamping it so that the
+/// writer can merge every CPU's records in order.
+/// @param lane SVRTY_PERCPU_LANE_HIGH or SVRTY_PERCPU_LANE_LOW.
+/// @param drop_if_full Drop the record if the segment is full (T), or wait for the writer (F).
+/// @param length Record length.
+/// @param render Function that writes the record into the segment.
+/// @param context Data passed to render.
+/// @return 0 if staged, SVRTY_PERCPU_DROPPED if dropped, < 0 if staging is disabled or
+/// the record does not fit in a segment.
+///////////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogPerCpuStage(const int lane, const bool drop_if_full, const size_t length, SVRTY_PERCPU_RENDER render, const void* context)
+{
+    // Segments are not freed while any producer is using them.
+    __atomic_add_fetch(&percpu_users, 1, __ATOMIC_SEQ_CST);
+
+    if(!__atomic_load_n(&percpu_active, __ATOMIC_SEQ_CST))
+    {
+        SeverityLogPerCpuLeave();
+
+        SeverityLogPerCpuWaitExit();
+
+        return SVRTY_PERCPU_NOT_ACTIVE;
+    }
+
+    size_t record_size = SVRTY_PERCPU_ALIGN(sizeof(SVRTY_PERCPU_RECORD) + length);
+
+    if(record_size > percpu_segment_size)
+    {
+        SeverityLogPerCpuLeave();
+        return SVRTY_PERCPU_TOO_LARGE;
+    }
+
+    int cpu = sched_getcpu();
+
+    // Migrating right after this call is harmless: it only means sharing another CPU's lock.
+    SVRTY_PERCPU* staging = &percpu[lane][(cpu < 0 ? 0 : (size_t)cpu % percpu_amount)];
+
+    pthread_mutex_lock(&staging->lock);
+
+    while(staging->used + record_size > percpu_segment_size)
+    {
+        // Taken while the segment is known to be full: any collection counted after this point collects
+        // every record in it (they are all older than its cutoff), unless it started before.
+        uint64_t full_collect_count = __atomic_load_n(&collect_count, __ATOMIC_RELAXED);
+
+        pthread_mutex_unlock(&staging->lock);
+
+        if(drop_if_full)
+        {
+            __atomic_add_fetch(&percpu_dropped, 1, __ATOMIC_RELAXED);
+            SeverityLogPerCpuLeave();
+            return SVRTY_PERCPU_DROPPED;
+        }
+
+        pthread_mutex_lock(&writer_mtx);
+
+        pthread_cond_signal(&writer_cond);
+
+        while(collect_count == full_collect_count)
+            pthread_cond_wait(&space_cond, &writer_mtx);
+
+        pthread_mutex_unlock(&writer_mtx);
+
+        pthread_mutex_lock(&staging->lock);
+    }
+
+    SVRTY_PERCPU_RECORD* record = (SVRTY_PERCPU_RECORD*)(staging->segment + staging->used);
+
+    // Timestamp is taken under the lock, so records within a segment are always sorted.
+    record->timestamp_ns    = SeverityLogPerCpuNow();
+    record->length          = (uint32_t)length;
+
+    render((char*)(record + 1), context);
+
+    size_t previous_used    = staging->used;
+    size_t current_used     = previous_used + record_size;
+
+    // Writer peeks at it without taking the lock, to skip empty segments.
+    __atomic_store_n(&staging->used, current_used, __ATOMIC_RELAXED);
+
+    pthread_mutex_unlock(&staging->lock);
+
+    // High priority records wake the writer up right away (even if it is draining the low
+    // priority lane). Otherwise, writer is only woken up once per half segment.
+    if(lane == SVRTY_PERCPU_LANE_HIGH)
+    {
+        if(!__atomic_load_n(&high_lane_staged, __ATOMIC_RELAXED))
+            __atomic_store_n(&high_lane_staged, true, __ATOMIC_SEQ_CST);
+
+        SeverityLogPerCpuWakeWriter();
+    }
+    else if(previous_used < (percpu_segment_size / 2) && current_used >= (percpu_segment_size / 2))
+    {
+        SeverityLogPerCpuWakeWriter();
+    }
+
+    SeverityLogPerCpuLeave();
+
+    return SVRTY_PERCPU_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// @brief Gets the timestamp of the next record to be merged from a given CPU.
+/// @param lane Target lane.
+/// @param cpu Target CPU.
+/// @return Record's timestamp, UINT64_MAX if there are no records left.
+///////////////////////////////////////////////////////////////////////////////
+static uint64_t SeverityLogPerCpuHeadTimestamp(const int lane, const size_t cpu)
+{
+    SVRTY_PERCPU* staging = &percpu[lane][cpu];
+
+    if(staging->pending_offset >= staging->pending_used)
+        return UINT64_MAX;
+
+    return ((SVRTY_PERCPU_RECORD*)(staging->pending + staging->pending_offset))->timestamp_ns;
+}
+
+//////////////////////////////////////////////////////////////////////
+/// @brief Restores merge heap order (smallest head timestamp on top).
+/// @param lane Target lane.
+/// @param heap_size Number of CPUs in the heap.
+/// @param idx Heap index to be moved down.
+//////////////////////////////////////////////////////////////////////
+static void SeverityLogPerCpuHeapSiftDown(const int lane, size_t heap_size, size_t idx)
+{
+    size_t* heap = merge_heap[lane];
+
+    while(true)
+    {
+        size_t smallest = idx;
+        size_t left     = (2 * idx) + 1;
+        size_t right    = (2 * idx) + 2;
+
+        if(left < heap_size && SeverityLogPerCpuHeadTimestamp(lane, heap[left]) < SeverityLogPerCpuHeadTimestamp(lane, heap[smallest]))
+            smallest = left;
+
+        if(right < heap_size && SeverityLogPerCpuHeadTimestamp(lane, heap[right]) < SeverityLogPerCpuHeadTimestamp(lane, heap[smallest]))
+            smallest = right;
+
+        if(smallest == idx)
+            return;
+
+        size_t swap     = heap[idx];
+        heap[idx]       = heap[smallest];
+        heap[smallest]  = swap;
+
+        idx = smallest;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Moves staged records into the writer-private pending buffers, so that segment
+/// locks are only held during a memcpy. Records newer than cutoff_ns are left staged, as
+/// older ones may still be staged in segments that were collected before them. As a
+/// consequence, pending buffers never hold more than a segment, and are emptied by every
+/// merge.
+/// @param lane Target lane.
+/// @param cutoff_ns Timestamp taken before collecting records.
+/////////////////////////////////////////////////////////////////////////////////////////
+static void SeverityLogPerCpuCollect(const int lane, const uint64_t cutoff_ns)
+{
+    for(size_t cpu = 0; cpu < percpu_amount; cpu++)
+    {
+        SVRTY_PERCPU* staging = &percpu[lane][cpu];
+
+        if(__atomic_load_n(&staging->used, __ATOMIC_RELAXED) == 0)
+            continue;
+
+        pthread_mutex_lock(&staging->lock);
+
+        size_t collected = 0;
+
+        // Records within a segment are sorted, so newer ones are found at its end (if any).
+        while(collected < staging->used)
+        {
+            const SVRTY_PERCPU_RECORD* record = (const SVRTY_PERCPU_RECORD*)(staging->segment + collected);
+
+            if(record->timestamp_ns > cutoff_ns)
+                break;
+
+            collected += SVRTY_PERCPU_ALIGN(sizeof(SVRTY_PERCPU_RECORD) + record->length);
+        }
+
+        memcpy(staging->pending, staging->segment, collected);
+        memmove(staging->segment, staging->segment + collected, staging->used - collected);
+
+        staging->pending_used = collected;
+
+        __atomic_store_n(&staging->used, staging->used - collected, __ATOMIC_RELAXED);
+
+        pthread_mutex_unlock(&staging->lock);
+    }
+
+    // Wakes up producers waiting for their segment to be emptied.
+    pthread_mutex_lock(&writer_mtx);
+    __atomic_store_n(&collect_count, collect_count + 1, __ATOMIC_RELAXED);
+    pthread_cond_broadcast(&space_cond);
+    pthread_mutex_unlock(&writer_mtx);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Merges (k-way) every CPU's pending records by timestamp and outputs them. While
+/// merging the low priority lane, high priority records are output as soon as they are
+/// staged.
+/// @param lane Target lane.
+//////////////////////////////////////////////////////////////////////////////////////////
+static void SeverityLogPerCpuMerge(const int lane)
+{
+    struct iovec iov[SVRTY_PERCPU_IOV_MAX];
+    int iovcnt = 0;
+    size_t heap_size = 0;
+    size_t* heap = merge_heap[lane];
+
+    for(size_t cpu = 0; cpu < percpu_amount; cpu++)
+        if(SeverityLogPerCpuHeadTimestamp(lane, cpu) != UINT64_MAX)
+            heap[heap_size++] = cpu;
+
+    for(size_t idx = heap_size; idx > 0; idx--)
+        SeverityLogPerCpuHeapSiftDown(lane, heap_size, idx - 1);
+
+    while(heap_size > 0)
+    {
+        SVRTY_PERCPU* staging = &percpu[lane][heap[0]];
+        SVRTY_PERCPU_RECORD* record = (SVRTY_PERCPU_RECORD*)(staging->pending + staging->pending_offset);
+
+        iov[iovcnt].iov_base    = (void*)(record + 1);
+        iov[iovcnt].iov_len     = record->length;
+        ++iovcnt;
+
+        staging->pending_offset += SVRTY_PERCPU_ALIGN(sizeof(SVRTY_PERCPU_RECORD) + record->length);
+
+        if(SeverityLogPerCpuHeadTimestamp(lane, heap[0]) == UINT64_MAX)
+            heap[0] = heap[--heap_size];
+
+        SeverityLogPerCpuHeapSiftDown(lane, heap_size, 0);
+
+        if(iovcnt == SVRTY_PERCPU_IOV_MAX)
+        {
+            percpu_output(iov, iovcnt);
+            iovcnt = 0;
+
+            // Lanes do not share any state, so high priority records can jump in at this point.
+            if(lane == SVRTY_PERCPU_LANE_LOW && __atomic_load_n(&high_lane_staged, __ATOMIC_SEQ_CST))
+                SeverityLogPerCpuDrainHigh();
+        }
+    }
+
+    if(iovcnt > 0)
+        percpu_output(iov, iovcnt);
+
+    // Every pending record has been output.
+    for(size_t cpu = 0; cpu < percpu_amount; cpu++)
+    {
+        percpu[lane][cpu].pending_used      = 0;
+        percpu[lane][cpu].pending_offset    = 0;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+/// @brief Collects, merges and outputs every record staged into a lane.
+/// @param lane Target lane.
+////////////////////////////////////////////////////////////////////////
+static void SeverityLogPerCpuDrain(const int lane)
+{
+    uint64_t cutoff_ns = SeverityLogPerCpuNow();
+
+    SeverityLogPerCpuCollect(lane, cutoff_ns);
+    SeverityLogPerCpuMerge(lane);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// @brief Drains the high priority lane, then wakes up callers waiting for it.
+///////////////////////////////////////////////////////////////////////////////
+static void SeverityLogPerCpuDrainHigh(void)
+{
+    pthread_mutex_lock(&writer_mtx);
+    uint64_t flush_ticket = flush_requested;
+    pthread_mutex_unlock(&writer_mtx);
+
+    __atomic_store_n(&high_lane_staged, false, __ATOMIC_SEQ_CST);
+
+    SeverityLogPerCpuDrain(SVRTY_PERCPU_LANE_HIGH);
+
+    pthread_mutex_lock(&writer_mtx);
+
+    if(flush_ticket > high_flush_done)
+        high_flush_done = flush_ticket;
+
+    pthread_cond_broadcast(&flush_cond);
+    pthread_mutex_unlock(&writer_mtx);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Writer thread. Periodically (or when woken up) collects records
+/// from every CPU, merges and outputs them (high priority lane first).
+/// @param arg Unused.
+/// @return NULL.
+//////////////////////////////////////////////////////////////////////////
+static void* SeverityLogPerCpuWriter(void* arg)
+{
+    pthread_mutex_lock(&writer_mtx);
+
+    while(true)
+    {
+        bool stopping           = writer_stop;
+        uint64_t flush_ticket   = flush_requested;
+
+        pthread_mutex_unlock(&writer_mtx);
+
+        SeverityLogPerCpuDrainHigh();
+        SeverityLogPerCpuDrain(SVRTY_PERCPU_LANE_LOW);
+
+        pthread_mutex_lock(&writer_mtx);
+
+        flush_done = flush_ticket;
+
+        if(flush_ticket > high_flush_done)
+            high_flush_done = flush_ticket;
+
+        pthread_cond_broadcast(&flush_cond);
+
+        if(stopping)
+            break;
+
+        if(writer_stop || flush_requested != flush_done || __atomic_load_n(&high_lane_staged, __ATOMIC_SEQ_CST))
+            continue;
+
+        struct timespec wake_time;
+        clock_gettime(CLOCK_REALTIME, &wake_time);
+
+        wake_time.tv_nsec += SVRTY_PERCPU_PERIOD_NS;
+
+        if(wake_time.tv_nsec >= (long)SVRTY_PERCPU_NS_PER_SEC)
+        {
+            wake_time.tv_sec    += 1;
+            wake_time.tv_nsec   -= (long)SVRTY_PERCPU_NS_PER_SEC;
+        }
+
+        pthread_cond_timedwait(&writer_cond, &writer_mtx, &wake_time);
+    }
+
+    pthread_mutex_unlock(&writer_mtx);
+
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////
+/// @brief Waits until every record staged so far has been output.
+/// Must not be called while holding any lock the output function takes.
+/// @param high_lane_only Only wait for the high priority lane (T/F).
+////////////////////////////////////////////////////////////////////////
+void SeverityLogPerCpuFlush(const bool high_lane_only)
+{
+    pthread_mutex_lock(&percpu_control_mtx);
+
+    if(!percpu_active)
+    {
+        pthread_mutex_unlock(&percpu_control_mtx);
+        return;
+    }
+
+    pthread_mutex_lock(&writer_mtx);
+
+    uint64_t flush_ticket = ++flush_requested;
+
+    // Makes the writer serve the high priority lane right away, even if it is busy with the other one.
+    if(high_lane_only)
+        __atomic_store_n(&high_lane_staged, true, __ATOMIC_SEQ_CST);
+
+    pthread_cond_signal(&writer_cond);
+
+    while((high_lane_only ? high_flush_done : flush_done) < flush_ticket)
+        pthread_cond_wait(&flush_cond, &writer_mtx);
+
+    pthread_mutex_unlock(&writer_mtx);
+
+    pthread_mutex_unlock(&percpu_control_mtx);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @brief Outputs every staged record, then stops the writer thread and frees
+/// every segment.
+//////////////////////////////////////////////////////////////////////////////
+void SeverityLogPerCpuExit(void)
+{
+    pthread_mutex_lock(&percpu_control_mtx);
+
+    if(!percpu_active)
+    {
+        pthread_mutex_unlock(&percpu_control_mtx);
+        return;
+    }
+
+    __atomic_store_n(&percpu_exiting, true, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&percpu_active, false, __ATOMIC_SEQ_CST);
+
+    // New producers fall back to synchronous logging once staged records are output: wait for ongoing ones
+    // (the last one to leave wakes this thread up, see SeverityLogPerCpuLeave). Producers waiting for space
+    // are served by the writer meanwhile.
+    pthread_mutex_lock(&writer_mtx);
+
+    while(__atomic_load_n(&percpu_users, __ATOMIC_SEQ_CST) > 0)
+        pthread_cond_wait(&users_cond, &writer_mtx);
+
+    // Writer performs a last collection before exiting, so nothing staged is lost.
+    writer_stop = true;
+    pthread_cond_signal(&writer_cond);
+    pthread_mutex_unlock(&writer_mtx);
+
+    pthread_join(writer_thread, NULL);
+
+    for(int lane = 0; lane < SVRTY_PERCPU_LANE_AMOUNT; lane++)
+        for(size_t cpu = 0; cpu < percpu_amount; cpu++)
+            pthread_mutex_destroy(&percpu[lane][cpu].lock);
+
+    SeverityLogPerCpuFree();
+
+    __atomic_store_n(&percpu_exiting, false, __ATOMIC_SEQ_CST);
+
+    pthread_mutex_unlock(&percpu_control_mtx);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// @brief Gets the number of records dropped because their segment was full.
+/// @return Number of dropped records.
+/////////////////////////////////////////////////////////////////////////////
+uint64_t SeverityLogPerCpuDropped(void)
+{
+    return __atomic_load_n(&percpu_dropped, __ATOMIC_RELAXED);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// @brief Frees every segment, without waiting for the writer thread (which
+/// does not exist anymore). Meant to be used by child processes, after fork.
+/////////////////////////////////////////////////////////////////////////////
+void SeverityLogPerCpuRelease(void)
+{
+    // Parent's threads may have been waiting on these at fork (mutexes were not held by anyone, see
+    // SeverityLogPerCpuLock, so staging was not being enabled or disabled either).
+    pthread_cond_init(&writer_cond, NULL);
+    pthread_cond_init(&flush_cond, NULL);
+    pthread_cond_init(&space_cond, NULL);
+    pthread_cond_init(&users_cond, NULL);
+
+    if(!percpu_active)
+        return;
+
+    percpu_active   = false;
+    percpu_exiting  = false;
+    percpu_users    = 0;
+
+    SeverityLogPerCpuFree();
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/// @brief Takes the control and writer mutexes (in this order), so that fork does
+/// not take place while another thread holds them, nor while staging is being
+/// enabled or disabled. Released by SeverityLogPerCpuUnlock (in both parent and
+/// child processes).
+//////////////////////////////////////////////////////////////////////////////////
+void SeverityLogPerCpuLock(void)
+{
+    pthread_mutex_lock(&percpu_control_mtx);
+    pthread_mutex_lock(&writer_mtx);
+}
+
+///////////////////////////////////////////////////////////////
+/// @brief Releases the mutexes taken by SeverityLogPerCpuLock.
+///////////////////////////////////////////////////////////////
+void SeverityLogPerCpuUnlock(void)
+{
+    pthread_mutex_unlock(&writer_mtx);
+    pthread_mutex_unlock(&percpu_control_mtx);
+}
+
+/*************************************/
@@ -0,0 +1,123 @@
+#ifndef SEVERITY_LOG_PER_CPU_H
+#define SEVERITY_LOG_PER_CPU_H
+
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/uio.h>
+
+/************************************/
+
+/***********************************/
+/******** Define statements ********/
+/***********************************/
+
+#define SVRTY_PERCPU_SUCCESS        0
+#define SVRTY_PERCPU_NOT_ACTIVE     -1
+#define SVRTY_PERCPU_TOO_LARGE      -2
+#define SVRTY_PERCPU_INIT_ERR       -3
+#define SVRTY_PERCPU_DROPPED        -4
+
+#define SVRTY_PERCPU_LANE_HIGH      0   // Drained first. Meant for records that must never be dropped.
+#define SVRTY_PERCPU_LANE_LOW       1
+#define SVRTY_PERCPU_LANE_AMOUNT    2
+
+/***********************************/
+
+/**********************************/
+/******** Type definitions ********/
+/**********************************/
+
+/// @brief Writes a record's content (as many bytes as requested when staging it) into destination.
+typedef void (*SVRTY_PERCPU_RENDER)(char* destination, const void* context);
+
+/// @brief Outputs merged records. Called from the writer thread only.
+typedef void (*SVRTY_PERCPU_OUTPUT)(struct iovec* iov, int iovcnt);
+
+/**********************************/
+
+/*************************************/
+/******** Function prototypes ********/
+/*************************************/
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Allocates a staging segment per CPU and starts the writer thread that drains them.
+/// @param segment_size Size of each CPU's staging segment.
+/// @param writer_cpus CPUs the writer thread is pinned to (NULL does not pin it).
+/// @param writer_cpu_amount Number of elements in writer_cpus.
+/// @param output Function merged records are handed to.
+/// @return 0 if succeeded, < 0 otherwise (i.e. if staging was already enabled).
+/////////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogPerCpuInit(const size_t segment_size, const int* writer_cpus, const size_t writer_cpu_amount, SVRTY_PERCPU_OUTPUT output);
+
+////////////////////////////////////////////////////
+/// @brief Tells whether per-CPU staging is enabled.
+/// @return true if enabled, false otherwise.
+////////////////////////////////////////////////////
+bool SeverityLogPerCpuIsActive(void);
+
+//////////////////////////////////////////////////////////////////////////////////
+/// @brief Waits until staging is completely disabled, if it is being disabled, so
+/// that synchronous logs do not overtake records that are still being output.
+/// Returns right away otherwise.
+//////////////////////////////////////////////////////////////////////////////////
+void SeverityLogPerCpuWaitExit(void);
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Stages a record into the calling CPU's segment, timestamping it so that the
+/// writer can merge every CPU's records in order.
+/// @param lane SVRTY_PERCPU_LANE_HIGH or SVRTY_PERCPU_LANE_LOW.
+/// @param drop_if_full Drop the record if the segment is full (T), or wait for the writer (F).
+/// @param length Record length.
+/// @param render Function that writes the record into the segment.
+/// @param context Data passed to render.
+/// @return 0 if staged, SVRTY_PERCPU_DROPPED if dropped, < 0 if staging is disabled or
+/// the record does not fit in a segment.
+///////////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogPerCpuStage(const int lane, const bool drop_if_full, const size_t length, SVRTY_PERCPU_RENDER render, const void* context);
+
+////////////////////////////////////////////////////////////////////////
+/// @brief Waits until every record staged so far has been output.
+/// Must not be called while holding any lock the output function takes.
+/// @param high_lane_only Only wait for the high priority lane (T/F).
+////////////////////////////////////////////////////////////////////////
+void SeverityLogPerCpuFlush(const bool high_lane_only);
+
+/////////////////////////////////////////////////////////////////////////////
+/// @brief Gets the number of records dropped because their segment was full.
+/// @return Number of dropped records.
+/////////////////////////////////////////////////////////////////////////////
+uint64_t SeverityLogPerCpuDropped(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @brief Outputs every staged record, then stops the writer thread and frees
+/// every segment.
+//////////////////////////////////////////////////////////////////////////////
+void SeverityLogPerCpuExit(void);
+
+/////////////////////////////////////////////////////////////////////////////
+/// @brief Frees every segment, without waiting for the writer thread (which
+/// does not exist anymore). Meant to be used by child processes, after fork.
+/////////////////////////////////////////////////////////////////////////////
+void SeverityLogPerCpuRelease(void);
+
+//////////////////////////////////////////////////////////////////////////////////
+/// @brief Takes the control and writer mutexes (in this order), so that fork does
+/// not take place while another thread holds them, nor while staging is being
+/// enabled or disabled. Released by SeverityLogPerCpuUnlock (in both parent and
+/// child processes).
+//////////////////////////////////////////////////////////////////////////////////
+void SeverityLogPerCpuLock(void);
+
+///////////////////////////////////////////////////////////////
+/// @brief Releases the mutexes taken by SeverityLogPerCpuLock.
+///////////////////////////////////////////////////////////////
+void SeverityLogPerCpuUnlock(void);
+
+/*************************************/
+
+#endif
@@ -0,0 +1,523 @@
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "SeverityLogShm.h"
+#include "SeverityLogShm_api.h"
+
+/************************************/
+
+/***********************************/
+/******** Define statements ********/
+/***********************************/
+
+#define SVRTY_SHM_ALIGNMENT         64
+#define SVRTY_SHM_MIN_SLOT_SIZE     128
+#define SVRTY_SHM_MAX_SLOT_AMOUNT   (1U << 24)
+#define SVRTY_SHM_MAX_SLOT_SIZE     (1U << 20)
+#define SVRTY_SHM_ATTACH_RETRIES    1000    // Times to check whether the creator has initialized the ring.
+#define SVRTY_SHM_ATTACH_WAIT_NS    1000000 // Time between checks.
+
+#define SVRTY_SHM_MS_PER_SEC    1000
+#define SVRTY_SHM_NS_PER_MS     1000000L
+
+// Layout is documented in SeverityLogShm_api.h, so it must not change unnoticed.
+_Static_assert(sizeof(SVRTY_SHM_HEADER) == 64, "Unexpected shared memory ring header size.");
+_Static_assert(sizeof(SVRTY_SHM_RECORD) == 32, "Unexpected shared memory record header size.");
+
+/***********************************/
+
+/***********************************/
+/******** Private variables ********/
+/***********************************/
+
+static          SVRTY_SHM_HEADER*   shm_header      = NULL  ;
+static          size_t              shm_map_size    = 0     ;
+static          uint32_t            shm_pid         = 0     ;
+static __thread uint32_t            shm_tid         = 0     ;
+
+/***********************************/
+
+/*************************************/
+/**** Private function prototypes ****/
+/*************************************/
+
+static uint32_t SeverityLogShmRoundUpPow2(uint32_t value);
+static size_t SeverityLogShmMapSize(const uint32_t slot_amount, const uint32_t slot_size);
+static SVRTY_SHM_RECORD* SeverityLogShmSlot(SVRTY_SHM_HEADER* header, const uint64_t seq);
+static bool SeverityLogShmLayoutValid(const SVRTY_SHM_HEADER* header, const size_t map_size);
+static int SeverityLogShmAttach(const char* name, SVRTY_SHM_HEADER** header, size_t* map_size);
+static void SeverityLogShmFutexWake(SVRTY_SHM_HEADER* header);
+static int SeverityLogShmFutexWait(SVRTY_SHM_HEADER* header, const uint32_t value, const int timeout_ms);
+
+/*************************************/
+
+/*************************************/
+/******* Function definitions ********/
+/*************************************/
+
+///////////////////////////////////////////////////////
+/// @brief Rounds a value up to the next power of two.
+/// @param value Target value.
+/// @return Smallest power of two not lower than value.
+///////////////////////////////////////////////////////
+static uint32_t SeverityLogShmRoundUpPow2(uint32_t value)
+{
+    uint32_t pow2 = 1;
+
+    while(pow2 < value)
+        pow2 <<= 1;
+
+    return pow2;
+}
+
+///////////////////////////////////////////////////
+/// @brief Computes the size of a ring.
+/// @param slot_amount Number of slots.
+/// @param slot_size Size of each slot.
+/// @return Size of the whole shared memory object.
+///////////////////////////////////////////////////
+static size_t SeverityLogShmMapSize(const uint32_t slot_amount, const uint32_t slot_size)
+{
+    return sizeof(SVRTY_SHM_HEADER) + ((size_t)slot_amount * slot_size);
+}
+
+///////////////////////////////////////////////////////////
+/// @brief Gets the slot in which a given record is stored.
+/// @param header Target ring.
+/// @param seq Record number.
+/// @return Pointer to the slot.
+///////////////////////////////////////////////////////////
+static SVRTY_SHM_RECORD* SeverityLogShmSlot(SVRTY_SHM_HEADER* header, const uint64_t seq)
+{
+    size_t slot_idx = (size_t)(seq & (header->slot_amount - 1));
+
+    return (SVRTY_SHM_RECORD*)((char*)header + sizeof(SVRTY_SHM_HEADER) + (slot_idx * header->slot_size));
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// @brief Checks whether a mapped object is a ring this library can handle.
+/// @param header Mapped object.
+/// @param map_size Mapped object size.
+/// @return true if valid, false otherwise.
+////////////////////////////////////////////////////////////////////////////
+static bool SeverityLogShmLayoutValid(const SVRTY_SHM_HEADER* header, const size_t map_size)
+{
+    if(header->version != SVRTY_SHM_VERSION)
+        return false;
+
+    if(header->slot_amount == 0 || (header->slot_amount & (header->slot_amount - 1)) != 0)
+        return false;
+
+    if(header->slot_size < SVRTY_SHM_MIN_SLOT_SIZE || (header->slot_size % SVRTY_SHM_ALIGNMENT) != 0)
+        return false;
+
+    return (SeverityLogShmMapSize(header->slot_amount, header->slot_size) <= map_size);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Maps an existing ring, waiting (for a while) for its creator to initialize it.
+/// @param name Shared memory object name.
+/// @param header Mapped ring.
+/// @param map_size Mapped size.
+/// @return 0 if succeeded, < 0 otherwise.
+/////////////////////////////////////////////////////////////////////////////////////////
+static int SeverityLogShmAttach(const char* name, SVRTY_SHM_HEADER** header, size_t* map_size)
+{
+    const struct timespec attach_wait = {0, SVRTY_SHM_ATTACH_WAIT_NS};
+
+    int fd = shm_open(name, O_RDWR, 0);
+
+    if(fd < 0)
+        return SVRTY_SHM_OPEN_ERR;
+
+    struct stat shm_stat;
+    int retries = SVRTY_SHM_ATTACH_RETRIES;
+
+    // Creator may not have set the object's size yet.
+    while(fstat(fd, &shm_stat) == 0 && (size_t)shm_stat.st_size < sizeof(SVRTY_SHM_HEADER) && retries-- > 0)
+        nanosleep(&attach_wait, NULL);
+
+    if((size_t)shm_stat.st_size < sizeof(SVRTY_SHM_HEADER))
+    {
+        close(fd);
+        return SVRTY_SHM_LAYOUT_ERR;
+    }
+
+    void* map = mmap(NULL, (size_t)shm_stat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if(map == MAP_FAILED)
+        return SVRTY_SHM_OPEN_ERR;
+
+    SVRTY_SHM_HEADER* mapped_header = (SVRTY_SHM_HEADER*)map;
+
+    while(__atomic_load_n(&mapped_header->magic, __ATOMIC_ACQUIRE) != SVRTY_SHM_MAGIC && retries-- > 0)
+        nanosleep(&attach_wait, NULL);
+
+    if(mapped_header->magic != SVRTY_SHM_MAGIC || !SeverityLogShmLayoutValid(mapped_header, (size_t)shm_stat.st_size))
+    {
+        munmap(map, (size_t)shm_stat.st_size);
+        return SVRTY_SHM_LAYOUT_ERR;
+    }
+
+    *header     = mapped_header;
+    *map_size   = (size_t)shm_stat.st_size;
+
+    return SVRTY_SHM_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Creates (or attaches to) a named shared memory ring in which logs are published.
+/// If the ring already exists, its geometry is kept.
+/// @param name Shared memory object name (i.e. "/my_log").
+/// @param slot_amount Number of slots (rounded up to a power of two).
+/// @param slot_size Size of each slot (rounded up to a multiple of 64).
+/// @return 0 if succeeded, < 0 otherwise.
+///////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogShmOpen(const char* name, const uint32_t slot_amount, const uint32_t slot_size)
+{
+    SeverityLogShmClose();
+
+    if(name == NULL || slot_amount == 0 || slot_amount > SVRTY_SHM_MAX_SLOT_AMOUNT || slot_size > SVRTY_SHM_MAX_SLOT_SIZE)
+        return SVRTY_SHM_OPEN_ERR;
+
+    uint32_t ring_slot_amount   = SeverityLogShmRoundUpPow2(slot_amount);
+    uint32_t ring_slot_size     = ((slot_size + SVRTY_SHM_ALIGNMENT - 1) / SVRTY_SHM_ALIGNMENT) * SVRTY_SHM_ALIGNMENT;
+
+    if(ring_slot_size < SVRTY_SHM_MIN_SLOT_SIZE)
+        ring_slot_size = SVRTY_SHM_MIN_SLOT_SIZE;
+
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+
+    // Someone else created it: use it as it is.
+    if(fd < 0 && errno == EEXIST)
+        return SeverityLogShmAttach(name, &shm_header, &shm_map_size);
+
+    if(fd < 0)
+        return SVRTY_SHM_OPEN_ERR;
+
+    size_t map_size = SeverityLogShmMapSize(ring_slot_amount, ring_slot_size);
+
+    if(ftruncate(fd, (off_t)map_size) < 0)
+    {
+        close(fd);
+        shm_unlink(name);
+        return SVRTY_SHM_OPEN_ERR;
+    }
+
+    void* map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if(map == MAP_FAILED)
+    {
+        shm_unlink(name);
+        return SVRTY_SHM_OPEN_ERR;
+    }
+
+    // Object is zero-filled by ftruncate, so only geometry has to be set before publishing magic.
+    SVRTY_SHM_HEADER* header = (SVRTY_SHM_HEADER*)map;
+
+    header->version     = SVRTY_SHM_VERSION;
+    header->slot_amount = ring_slot_amount;
+    header->slot_size   = ring_slot_size;
+
+    __atomic_store_n(&header->magic, SVRTY_SHM_MAGIC, __ATOMIC_RELEASE);
+
+    shm_header      = header;
+    shm_map_size    = map_size;
+
+    return SVRTY_SHM_SUCCESS;
+}
+
+//////////////////////////////////////////////////////////
+/// @brief Tells whether a shared memory ring is attached.
+/// @return true if attached, false otherwise.
+//////////////////////////////////////////////////////////
+bool SeverityLogShmIsOpen(void)
+{
+    return (shm_header != NULL);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @brief Wakes readers up, but only if any of them is waiting (no syscall is
+/// performed otherwise).
+/// @param header Target ring.
+//////////////////////////////////////////////////////////////////////////////
+static void SeverityLogShmFutexWake(SVRTY_SHM_HEADER* header)
+{
+    __atomic_add_fetch(&header->futex, 1, __ATOMIC_SEQ_CST);
+
+    if(__atomic_load_n(&header->waiters, __ATOMIC_SEQ_CST) == 0)
+        return;
+
+    syscall(SYS_futex, &header->futex, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Publishes a log line into the ring. Never waits for readers.
+/// @param severity Severity level.
+/// @param timestamp_ns CLOCK_REALTIME timestamp, in nanoseconds.
+/// @param context Context fields, placed before the line (does not need to be null-terminated).
+/// @param context_len Context fields length.
+/// @param line Target line (does not need to be null-terminated).
+/// @param line_len Line length. Lines longer than a slot's payload get truncated.
+////////////////////////////////////////////////////////////////////////////////////////////////
+void SeverityLogShmPublish(const uint8_t severity, const uint64_t timestamp_ns, const char* context, const size_t context_len, const char* line, const size_t line_len)
+{
+    SVRTY_SHM_HEADER* header = shm_header;
+
+    if(header == NULL)
+        return;
+
+    if(shm_pid == 0)
+        shm_pid = (uint32_t)getpid();
+
+    if(shm_tid == 0)
+        shm_tid = (uint32_t)syscall(SYS_gettid);
+
+    uint64_t seq = __atomic_fetch_add(&header->write_seq, 1, __ATOMIC_RELAXED);
+
+    SVRTY_SHM_RECORD* record = SeverityLogShmSlot(header, seq);
+    uint64_t slot_seq = __atomic_load_n(&record->seq, __ATOMIC_RELAXED);
+
+    // The slot can only be claimed while it holds an older, published record (or none at all). Otherwise,
+    // a writer a lap behind is still copying its record into it (or one a lap ahead already claimed it).
+    do
+    {
+        if(SVRTY_SHM_SEQ_IS_WRITING(slot_seq) || slot_seq > SVRTY_SHM_SEQ_WRITING(seq))
+        {
+            __atomic_fetch_add(&header->skipped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+    while(!__atomic_compare_exchange_n(&record->seq, &slot_seq, SVRTY_SHM_SEQ_WRITING(seq), true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    // Record seq - slot_amount is being overwritten: count it if the reader did not get to it.
+    if(seq >= __atomic_load_n(&header->read_seq, __ATOMIC_RELAXED) + header->slot_amount)
+        __atomic_fetch_add(&header->overwritten, 1, __ATOMIC_RELAXED);
+
+    size_t payload_capacity = header->slot_size - sizeof(SVRTY_SHM_RECORD) - 1;
+    size_t stored_context   = (context_len < payload_capacity ? context_len : payload_capacity);
+    size_t stored_line      = (line_len < payload_capacity - stored_context ? line_len : payload_capacity - stored_context);
+    size_t payload_len      = stored_context + stored_line;
+
+    record->timestamp_ns    = timestamp_ns                  ;
+    record->pid             = shm_pid                       ;
+    record->tid             = shm_tid                       ;
+    record->length          = (uint32_t)payload_len         ;
+    record->severity        = severity                      ;
+    record->context_length  = (uint16_t)stored_context      ;
+
+    memcpy(record->payload, context, stored_context);
+    memcpy(record->payload + stored_context, line, stored_line);
+    record->payload[payload_len] = '\0';
+
+    __atomic_store_n(&record->seq, SVRTY_SHM_SEQ_DONE(seq), __ATOMIC_RELEASE);
+
+    SeverityLogShmFutexWake(header);
+}
+
+////////////////////////////////////////////////////////////////////////
+/// @brief Discards cached process/thread IDs. Meant to be used by child
+/// processes, after fork.
+////////////////////////////////////////////////////////////////////////
+void SeverityLogShmAtForkChild(void)
+{
+    shm_pid = 0;
+    shm_tid = 0;
+}
+
+//////////////////////////////////////////////////////////////////
+/// @brief Detaches from the ring. The shared memory object is not
+/// removed, as readers (or other writers) may still be using it.
+//////////////////////////////////////////////////////////////////
+void SeverityLogShmClose(void)
+{
+    if(shm_header == NULL)
+        return;
+
+    munmap(shm_header, shm_map_size);
+
+    shm_header      = NULL;
+    shm_map_size    = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/// @brief Attaches a reader to an existing ring, starting from its oldest record.
+/// @param reader Target reader.
+/// @param name Shared memory object name (as provided to SetSeverityLogShmSink).
+/// @return 0 if succeeded, < 0 otherwise.
+//////////////////////////////////////////////////////////////////////////////////
+int SeverityLogShmReaderOpen(SVRTY_SHM_READER* reader, const char* name)
+{
+    if(reader == NULL || name == NULL)
+        return SVRTY_SHM_OPEN_ERR;
+
+    memset(reader, 0, sizeof(SVRTY_SHM_READER));
+
+    int attach = SeverityLogShmAttach(name, &reader->header, &reader->map_size);
+
+    if(attach < 0)
+        return attach;
+
+    uint64_t write_seq = __atomic_load_n(&reader->header->write_seq, __ATOMIC_ACQUIRE);
+
+    reader->next_seq = (write_seq > reader->header->slot_amount ? write_seq - reader->header->slot_amount : 0);
+
+    __atomic_store_n(&reader->header->read_seq, reader->next_seq, __ATOMIC_RELAXED);
+
+    return SVRTY_SHM_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////
+/// @brief Waits until the futex word changes (or the timeout expires).
+/// @param header Target ring.
+/// @param value Futex word value the caller has already seen.
+/// @param timeout_ms Time to wait for (< 0 waits indefinitely).
+/// @return 0 if woken up, SVRTY_SHM_NO_RECORD if the timeout expired.
+///////////////////////////////////////////////////////////////////////
+static int SeverityLogShmFutexWait(SVRTY_SHM_HEADER* header, const uint32_t value, const int timeout_ms)
+{
+    struct timespec timeout = { timeout_ms / SVRTY_SHM_MS_PER_SEC, (timeout_ms % SVRTY_SHM_MS_PER_SEC) * SVRTY_SHM_NS_PER_MS };
+
+    __atomic_add_fetch(&header->waiters, 1, __ATOMIC_SEQ_CST);
+
+    long ret = syscall(SYS_futex, &header->futex, FUTEX_WAIT, value, (timeout_ms < 0 ? NULL : &timeout), NULL, 0);
+    int wait_errno = errno;
+
+    __atomic_sub_fetch(&header->waiters, 1, __ATOMIC_SEQ_CST);
+
+    return ((ret < 0 && wait_errno == ETIMEDOUT) ? SVRTY_SHM_NO_RECORD : SVRTY_SHM_SUCCESS);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Gets the next record, without copying it. Once consumed, SeverityLogShmReaderRelease
+/// must be called, as the record may be overwritten by writers at any time.
+/// @param reader Target reader.
+/// @param record Pointer to the record within the ring.
+/// @param timeout_ms Time to wait for a record (0 does not block, < 0 waits indefinitely).
+/// @return 0 if a record is available, SVRTY_SHM_NO_RECORD otherwise.
+///////////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogShmReaderNext(SVRTY_SHM_READER* reader, const SVRTY_SHM_RECORD** record, const int timeout_ms)
+{
+    if(reader == NULL || reader->header == NULL || record == NULL)
+        return SVRTY_SHM_NO_RECORD;
+
+    SVRTY_SHM_HEADER* header = reader->header;
+
+    while(true)
+    {
+        // Taken before checking for records, so that no publication in between goes unnoticed.
+        uint32_t futex_value    = __atomic_load_n(&header->futex, __ATOMIC_SEQ_CST);
+        uint64_t write_seq      = __atomic_load_n(&header->write_seq, __ATOMIC_ACQUIRE);
+
+        // Reader fell behind by more than a whole lap: skip overwritten records.
+        if(write_seq > header->slot_amount && reader->next_seq < write_seq - header->slot_amount)
+        {
+            reader->lost        += (write_seq - header->slot_amount) - reader->next_seq;
+            reader->next_seq     = write_seq - header->slot_amount;
+        }
+
+        if(reader->next_seq < write_seq)
+        {
+            SVRTY_SHM_RECORD* slot = SeverityLogShmSlot(header, reader->next_seq);
+            uint64_t slot_seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+
+            if(slot_seq == SVRTY_SHM_SEQ_DONE(reader->next_seq))
+            {
+                *record = slot;
+                return SVRTY_SHM_SUCCESS;
+            }
+
+            // Already overwritten by a later record.
+            if(slot_seq > SVRTY_SHM_SEQ_DONE(reader->next_seq))
+            {
+                ++reader->lost;
+                ++reader->next_seq;
+                continue;
+            }
+
+            // Not claimed yet. If a later record was published meanwhile, this one was most likely skipped
+            // by its writer (see SeverityLogShmPublish), so it is not waited for.
+            if(reader->next_seq + 1 < write_seq)
+            {
+                SVRTY_SHM_RECORD* next_slot = SeverityLogShmSlot(header, reader->next_seq + 1);
+
+                if(slot_seq < SVRTY_SHM_SEQ_WRITING(reader->next_seq) && __atomic_load_n(&next_slot->seq, __ATOMIC_ACQUIRE) >= SVRTY_SHM_SEQ_DONE(reader->next_seq + 1))
+                {
+                    ++reader->lost;
+                    ++reader->next_seq;
+                    continue;
+                }
+            }
+
+            // Otherwise, it is still being written: wait for it to be published.
+        }
+
+        if(timeout_ms == 0 || SeverityLogShmFutexWait(header, futex_value, timeout_ms) < 0)
+            return SVRTY_SHM_NO_RECORD;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Releases the record returned by SeverityLogShmReaderNext, telling whether it remained
+/// intact while it was being consumed.
+/// @param reader Target reader.
+/// @return 0 if the record was intact, SVRTY_SHM_RECORD_LOST if it was overwritten meanwhile.
+////////////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogShmReaderRelease(SVRTY_SHM_READER* reader)
+{
+    if(reader == NULL || reader->header == NULL)
+        return SVRTY_SHM_RECORD_LOST;
+
+    SVRTY_SHM_RECORD* slot = SeverityLogShmSlot(reader->header, reader->next_seq);
+
+    // Every read performed on the record must happen before its sequence number is checked again.
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    int intact = (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == SVRTY_SHM_SEQ_DONE(reader->next_seq) ? SVRTY_SHM_SUCCESS : SVRTY_SHM_RECORD_LOST);
+
+    if(intact < 0)
+        ++reader->lost;
+
+    ++reader->next_seq;
+
+    __atomic_store_n(&reader->header->read_seq, reader->next_seq, __ATOMIC_RELEASE);
+
+    return intact;
+}
+
+///////////////////////////////////////////
+/// @brief Detaches a reader from its ring.
+/// @param reader Target reader.
+///////////////////////////////////////////
+void SeverityLogShmReaderClose(SVRTY_SHM_READER* reader)
+{
+    if(reader == NULL || reader->header == NULL)
+        return;
+
+    munmap(reader->header, reader->map_size);
+
+    reader->header      = NULL;
+    reader->map_size    = 0;
+}
+
+/*************************************/
@@ -0,0 +1,59 @@
+#ifndef SEVERITY_LOG_SHM_H
+#define SEVERITY_LOG_SHM_H
+
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/************************************/
+
+/*************************************/
+/******** Function prototypes ********/
+/*************************************/
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Creates (or attaches to) a named shared memory ring in which logs are published.
+/// If the ring already exists, its geometry is kept.
+/// @param name Shared memory object name (i.e. "/my_log").
+/// @param slot_amount Number of slots (rounded up to a power of two).
+/// @param slot_size Size of each slot (rounded up to a multiple of 64).
+/// @return 0 if succeeded, < 0 otherwise.
+///////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogShmOpen(const char* name, const uint32_t slot_amount, const uint32_t slot_size);
+
+//////////////////////////////////////////////////////////
+/// @brief Tells whether a shared memory ring is attached.
+/// @return true if attached, false otherwise.
+//////////////////////////////////////////////////////////
+bool SeverityLogShmIsOpen(void);
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Publishes a log line into the ring. Never waits for readers.
+/// @param severity Severity level.
+/// @param timestamp_ns CLOCK_REALTIME timestamp, in nanoseconds.
+/// @param context Context fields, placed before the line (does not need to be null-terminated).
+/// @param context_len Context fields length.
+/// @param line Target line (does not need to be null-terminated).
+/// @param line_len Line length. Lines longer than a slot's payload get truncated.
+////////////////////////////////////////////////////////////////////////////////////////////////
+void SeverityLogShmPublish(const uint8_t severity, const uint64_t timestamp_ns, const char* context, const size_t context_len, const char* line, const size_t line_len);
+
+////////////////////////////////////////////////////////////////////////
+/// @brief Discards cached process/thread IDs. Meant to be used by child
+/// processes, after fork.
+////////////////////////////////////////////////////////////////////////
+void SeverityLogShmAtForkChild(void);
+
+//////////////////////////////////////////////////////////////////
+/// @brief Detaches from the ring. The shared memory object is not
+/// removed, as readers (or other writers) may still be using it.
+//////////////////////////////////////////////////////////////////
+void SeverityLogShmClose(void);
+
+/*************************************/
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef SEVERITY_LOG_SHM_API_H
+#define SEVERITY_LOG_SHM_API_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "SeverityLog_api.h"
+
+/************************************/
+
+/***********************************/
+/******** Define statements ********/
+/***********************************/
+
+// Shared memory ring layout (every field is stored in native byte order):
+//
+//  offset 0                        SVRTY_SHM_HEADER (64 bytes).
+//  offset 64 + i * slot_size       Slot i (i < slot_amount), made of a SVRTY_SHM_RECORD header
+//                                  followed by a null-terminated payload. The payload starts with
+//                                  the logging thread's context fields (context_length bytes, i.e.
+//                                  "req=42 tenant=acme"), followed by the log line itself.
+//
+// Record N is written into slot (N & (slot_amount - 1)). Writers claim N by incrementing write_seq,
+// then compare-and-swap the slot's seq from an older SVRTY_SHM_SEQ_DONE value (or 0) to
+// SVRTY_SHM_SEQ_WRITING(N), copy the record and set seq to SVRTY_SHM_SEQ_DONE(N). If the slot is still
+// being written by a writer a lap behind, record N is skipped (counted in skipped): readers count it as
+// lost once a later record has been published. Writers never wait for readers: old records are
+// overwritten, and counted in overwritten if the reader (read_seq) had not consumed them yet. Every
+// published record increments the futex word, which readers can wait on (FUTEX_WAIT, not process-private).
+
+#define SVRTY_SHM_MAGIC     0x474C5653  // "SVLG"
+#define SVRTY_SHM_VERSION   2
+
+#define SVRTY_SHM_SEQ_WRITING(N)    (((uint64_t)(N) << 1) + 1)
+#define SVRTY_SHM_SEQ_DONE(N)       (((uint64_t)(N) << 1) + 2)
+#define SVRTY_SHM_SEQ_IS_WRITING(S) (((S) & 1) != 0)
+
+#define SVRTY_SHM_SUCCESS       0
+#define SVRTY_SHM_OPEN_ERR      -1  // Shared memory object could not be opened or mapped.
+#define SVRTY_SHM_LAYOUT_ERR    -2  // Shared memory object is not a SeverityLog ring (or version mismatch).
+#define SVRTY_SHM_NO_RECORD     -3  // No record was published before the timeout expired.
+#define SVRTY_SHM_RECORD_LOST   -4  // Record was overwritten while it was being consumed.
+
+/***********************************/
+
+/**********************************/
+/******** Type definitions ********/
+/**********************************/
+
+/// @brief Ring header, placed at the beginning of the shared memory object.
+typedef struct
+{
+    uint32_t    magic           ;   // SVRTY_SHM_MAGIC, only set once the ring is fully initialized.
+    uint32_t    version         ;   // SVRTY_SHM_VERSION.
+    uint32_t    slot_amount     ;   // Number of slots (power of two).
+    uint32_t    slot_size       ;   // Size of each slot, record header included (multiple of 64).
+    uint64_t    write_seq       ;   // Next record number to be claimed by a writer.
+    uint64_t    read_seq        ;   // Next record number to be consumed, published by the reader.
+    uint64_t    overwritten     ;   // Records overwritten before the reader consumed them.
+    uint32_t    futex           ;   // Incremented after each published record.
+    uint32_t    waiters         ;   // Number of readers currently waiting on futex.
+    uint64_t    skipped         ;   // Records not published, as their slot was still being written a lap behind.
+    uint8_t     reserved[8]     ;
+} SVRTY_SHM_HEADER;
+
+/// @brief Record header, placed at the beginning of every slot.
+typedef struct
+{
+    uint64_t    seq             ;   // SVRTY_SHM_SEQ_WRITING(N) while record N is being written, SVRTY_SHM_SEQ_DONE(N) once published.
+    uint64_t    timestamp_ns    ;   // CLOCK_REALTIME, in nanoseconds.
+    uint32_t    pid             ;   // Logging process.
+    uint32_t    tid             ;   // Logging thread (kernel TID).
+    uint32_t    length          ;   // Payload length (null terminator not included).
+    uint8_t     severity        ;   // SVRTY_LVL_ERR, SVRTY_LVL_INF, SVRTY_LVL_WNG or SVRTY_LVL_DBG.
+    uint8_t     reserved        ;
+    uint16_t    context_length  ;   // Context fields length, at the beginning of the payload (0 if no context).
+    char        payload[]       ;   // Context fields followed by a single log line, null-terminated.
+} SVRTY_SHM_RECORD;
+
+/// @brief Ring reader. Only meant to be handled by SeverityLogShmReader* functions.
+typedef struct
+{
+    SVRTY_SHM_HEADER*   header      ;   // Mapped ring.
+    size_t              map_size    ;   // Mapped size.
+    uint64_t            next_seq    ;   // Next record number to be consumed.
+    uint64_t            lost        ;   // Records this reader did not get to consume.
+} SVRTY_SHM_READER;
+
+/**********************************/
+
+/*************************************/
+/******** Function prototypes ********/
+/*************************************/
+
+//////////////////////////////////////////////////////////////////////////////////
+/// @brief Attaches a reader to an existing ring, starting from its oldest record.
+/// @param reader Target reader.
+/// @param name Shared memory object name (as provided to SetSeverityLogShmSink).
+/// @return 0 if succeeded, < 0 otherwise.
+//////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SeverityLogShmReaderOpen(SVRTY_SHM_READER* reader, const char* name);
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Gets the next record, without copying it. Once consumed, SeverityLogShmReaderRelease
+/// must be called, as the record may be overwritten by writers at any time.
+/// @param reader Target reader.
+/// @param record Pointer to the record within the ring.
+/// @param timeout_ms Time to wait for a record (0 does not block, < 0 waits indefinitely).
+/// @return 0 if a record is available, SVRTY_SHM_NO_RECORD otherwise.
+///////////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SeverityLogShmReaderNext(SVRTY_SHM_READER* reader, const SVRTY_SHM_RECORD** record, const int timeout_ms);
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Releases the record returned by SeverityLogShmReaderNext, telling whether it remained
+/// intact while it was being consumed.
+/// @param reader Target reader.
+/// @return 0 if the record was intact, SVRTY_SHM_RECORD_LOST if it was overwritten meanwhile.
+////////////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SeverityLogShmReaderRelease(SVRTY_SHM_READER* reader);
+
+///////////////////////////////////////////
+/// @brief Detaches a reader from its ring.
+/// @param reader Target reader.
+///////////////////////////////////////////
+C_SEVERITY_LOG_API void SeverityLogShmReaderClose(SVRTY_SHM_READER* reader);
+
+/*************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,620 @@
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "SeverityLogUring.h"
+
+/************************************/
+
+/***********************************/
+/******** Define statements ********/
+/***********************************/
+
+#define SVRTY_URING_SUCCESS         0
+#define SVRTY_URING_NOT_SUPPORTED   -1
+#define SVRTY_URING_ALLOCATION_ERR  -2
+#define SVRTY_URING_NOT_INITIALIZED -3
+#define SVRTY_URING_THREAD_ERR      -4
+
+#define SVRTY_URING_CUR_POS         ((uint64_t)-1)
+#define SVRTY_URING_STOP_DATA       ((uint64_t)-1)  // user_data of the NOP that stops the completion thread.
+
+/***********************************/
+
+/**********************************/
+/******** Type definitions ********/
+/**********************************/
+
+typedef struct
+{
+    char*   data    ;   // Registered memory.
+    size_t  length  ;   // Bytes pending to be written.
+    size_t  written ;   // Bytes actually written, as completed.
+    int     fd      ;   // Target file descriptor.
+    bool    busy    ;   // Being filled, queued, or submitted and not completed yet.
+} SVRTY_URING_BUF;
+
+/**********************************/
+
+/***********************************/
+/******** Private variables ********/
+/***********************************/
+
+static int                  uring_fd                = -1    ;
+static void*                sq_ring_ptr             = NULL  ;
+static size_t               sq_ring_size            = 0     ;
+static void*                cq_ring_ptr             = NULL  ;
+static size_t               cq_ring_size            = 0     ;
+static struct io_uring_sqe* sqes                    = NULL  ;
+static size_t               sqes_size               = 0     ;
+static unsigned int*        sq_tail                 = NULL  ;
+static unsigned int*        sq_mask                 = NULL  ;
+static unsigned int*        sq_array                = NULL  ;
+static unsigned int*        cq_head                 = NULL  ;
+static unsigned int*        cq_tail                 = NULL  ;
+static unsigned int*        cq_mask                 = NULL  ;
+static struct io_uring_cqe* cqes                    = NULL  ;
+static SVRTY_URING_BUF*     uring_buffers           = NULL  ;
+static char*                uring_buffers_memory    = NULL  ;
+static unsigned int         uring_buffer_amount     = 0     ;
+static size_t               uring_buffer_size       = 0     ;
+static bool                 uring_buffers_registered= false ;
+static unsigned int         uring_in_flight         = 0     ;
+static unsigned int*        uring_chain             = NULL  ;
+static unsigned int         uring_chain_len         = 0     ;
+static unsigned int*        uring_queue             = NULL  ;
+static unsigned int         uring_queue_len         = 0     ;
+static pthread_t            uring_completer                 ;
+static pthread_mutex_t      uring_mtx               = PTHREAD_MUTEX_INITIALIZER ;
+static pthread_cond_t       uring_cond              = PTHREAD_COND_INITIALIZER  ;
+
+/***********************************/
+
+/*************************************/
+/**** Private function prototypes ****/
+/*************************************/
+
+static int  SeverityLogUringEnter(const unsigned int to_submit, const unsigned int min_complete);
+static void SeverityLogUringWriteSync(const int fd, const char* data, size_t length);
+static void SeverityLogUringCompleteChain(void);
+static bool SeverityLogUringReap(void);
+static struct io_uring_sqe* SeverityLogUringNextSqe(void);
+static void SeverityLogUringSubmitQueue(void);
+static int  SeverityLogUringGetFreeBuffer(void);
+static void* SeverityLogUringCompleter(void* arg);
+
+/*************************************/
+
+/*************************************/
+/******* Function definitions ********/
+/*************************************/
+
+/////////////////////////////////////////////////////////////////////////////
+/// @brief Submits queued SQEs and/or waits for completions.
+/// @param to_submit Number of queued SQEs to be submitted.
+/// @param min_complete Number of completions to wait for (0 does not block).
+/// @return Number of submitted SQEs, < 0 if any error happened.
+/////////////////////////////////////////////////////////////////////////////
+static int SeverityLogUringEnter(const unsigned int to_submit, const unsigned int min_complete)
+{
+    unsigned int flags = (min_complete > 0 ? IORING_ENTER_GETEVENTS : 0);
+    int ret;
+
+    do
+    {
+        ret = (int)syscall(__NR_io_uring_enter, uring_fd, to_submit, min_complete, flags, NULL, 0);
+    } while(ret < 0 && errno == EINTR);
+
+    return ret;
+}
+
+/////////////////////////////////////////////////////////////////////////
+/// @brief Writes data synchronously. Used to recover from failed writes.
+/// @param fd Target file descriptor.
+/// @param data Data to be written.
+/// @param length Data length.
+/////////////////////////////////////////////////////////////////////////
+static void SeverityLogUringWriteSync(const int fd, const char* data, size_t length)
+{
+    while(length > 0)
+    {
+        ssize_t written = write(fd, data, length);
+
+        if(written < 0 && errno == EINTR)
+            continue;
+
+        if(written <= 0)
+            return;
+
+        data    += written;
+        length  -= written;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Frees every buffer in the chain once all of its writes have completed. A short
+/// write cancels the rest of the chain, so nothing newer has been written by then and what
+/// is left is written synchronously, in submission order, rather than losing data. Called
+/// by the completion thread while holding uring_mtx, which is released meanwhile: chain
+/// buffers are not touched by anyone else, and queued ones are not submitted until the
+/// chain is empty.
+///////////////////////////////////////////////////////////////////////////////////////////
+static void SeverityLogUringCompleteChain(void)
+{
+    pthread_mutex_unlock(&uring_mtx);
+
+    for(unsigned int i = 0; i < uring_chain_len; i++)
+    {
+        SVRTY_URING_BUF* buffer = &uring_buffers[uring_chain[i]];
+
+        if(buffer->written < buffer->length)
+            SeverityLogUringWriteSync(buffer->fd, buffer->data + buffer->written, buffer->length - buffer->written);
+    }
+
+    pthread_mutex_lock(&uring_mtx);
+
+    for(unsigned int i = 0; i < uring_chain_len; i++)
+    {
+        SVRTY_URING_BUF* buffer = &uring_buffers[uring_chain[i]];
+
+        buffer->length  = 0;
+        buffer->written = 0;
+        buffer->busy    = false;
+    }
+
+    uring_chain_len = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Consumes every available completion. Only called by the completion
+/// thread (while holding uring_mtx), which is the only consumer of the CQ ring.
+/// @return true if the completion thread was asked to stop, false otherwise.
+////////////////////////////////////////////////////////////////////////////////
+static bool SeverityLogUringReap(void)
+{
+    bool stop = false;
+    unsigned int head = *cq_head;
+    unsigned int tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+
+    while(head != tail)
+    {
+        struct io_uring_cqe* cqe = &cqes[head & *cq_mask];
+
+        if(cqe->user_data == SVRTY_URING_STOP_DATA)
+        {
+            stop = true;
+        }
+        else
+        {
+            // Failed and cancelled writes (the ones after a short write) have written nothing.
+            uring_buffers[cqe->user_data].written = (cqe->res < 0 ? 0 : (size_t)cqe->res);
+            --uring_in_flight;
+        }
+
+        ++head;
+    }
+
+    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+    return stop;
+}
+
+///////////////////////////////////////////////////////////////////////
+/// @brief Gets the next SQE, to be filled and submitted by the caller.
+/// Must be called while holding uring_mtx.
+/// @return Cleared SQE.
+///////////////////////////////////////////////////////////////////////
+static struct io_uring_sqe* SeverityLogUringNextSqe(void)
+{
+    unsigned int tail = *sq_tail;
+    unsigned int idx = tail & *sq_mask;
+    struct io_uring_sqe* sqe = &sqes[idx];
+
+    memset(sqe, 0, sizeof(*sqe));
+
+    sq_array[idx] = idx;
+
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    return sqe;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Submits every queued buffer as a new chain, with a single system call. Writes are
+/// linked to the previous one, so that they are performed in order and a short one cancels
+/// the rest of the chain instead of letting newer data through before its remainder. Only a
+/// chain is in flight at a time, so queued buffers wait for the previous one to complete.
+/// Must be called while holding uring_mtx.
+////////////////////////////////////////////////////////////////////////////////////////////
+static void SeverityLogUringSubmitQueue(void)
+{
+    if(uring_chain_len > 0 || uring_queue_len == 0)
+        return;
+
+    for(unsigned int i = 0; i < uring_queue_len; i++)
+    {
+        unsigned int buffer_idx = uring_queue[i];
+        SVRTY_URING_BUF* buffer = &uring_buffers[buffer_idx];
+        struct io_uring_sqe* sqe = SeverityLogUringNextSqe();
+
+        sqe->opcode     = (uring_buffers_registered ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE);
+        sqe->flags      = (i + 1 < uring_queue_len ? IOSQE_IO_LINK : 0);
+        sqe->fd         = buffer->fd;
+        sqe->off        = SVRTY_URING_CUR_POS;
+        sqe->addr       = (uint64_t)(uintptr_t)buffer->data;
+        sqe->len        = (uint32_t)buffer->length;
+        sqe->buf_index  = (uint16_t)buffer_idx;
+        sqe->user_data  = buffer_idx;
+
+        uring_chain[uring_chain_len++] = buffer_idx;
+    }
+
+    uring_in_flight += uring_queue_len;
+
+    SeverityLogUringEnter(uring_queue_len, 0);
+
+    uring_queue_len = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// @brief Gets a buffer which is neither being filled, queued nor in flight. If there
+/// is none, queued buffers are submitted (if possible) and the function waits for the
+/// completion thread to free some. Must be called while holding uring_mtx.
+/// @return Free buffer index.
+//////////////////////////////////////////////////////////////////////////////////////
+static int SeverityLogUringGetFreeBuffer(void)
+{
+    while(true)
+    {
+        for(unsigned int i = 0; i < uring_buffer_amount; i++)
+        {
+            if(!uring_buffers[i].busy)
+            {
+                uring_buffers[i].busy = true;
+                return (int)i;
+            }
+        }
+
+        SeverityLogUringSubmitQueue();
+        pthread_cond_wait(&uring_cond, &uring_mtx);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Completion thread. Waits for completions, completes chains (short writes
+/// included) and submits whatever was queued meanwhile, so that loggers never wait for I/O
+/// unless every buffer is busy.
+/// @param arg Unused.
+/// @return NULL.
+///////////////////////////////////////////////////////////////////////////////////////////
+static void* SeverityLogUringCompleter(void* arg)
+{
+    bool stop = false;
+
+    while(!stop)
+    {
+        SeverityLogUringEnter(0, 1);
+
+        pthread_mutex_lock(&uring_mtx);
+
+        stop = SeverityLogUringReap();
+
+        if(uring_in_flight == 0 && uring_chain_len > 0)
+        {
+            SeverityLogUringCompleteChain();
+            SeverityLogUringSubmitQueue();
+        }
+
+        pthread_cond_broadcast(&uring_cond);
+        pthread_mutex_unlock(&uring_mtx);
+    }
+
+    return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Sets up an io_uring instance alongside its registered output buffers.
+/// @param buffer_amount Number of registered buffers (maximum amount of writes in flight).
+/// @param buffer_size Size of each registered buffer.
+/// @return 0 if succeeded, < 0 if io_uring is not supported (or allocation failed).
+///////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogUringInit(const unsigned int buffer_amount, const size_t buffer_size)
+{
+    if(uring_fd >= 0)
+        return SVRTY_URING_SUCCESS;
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    uring_fd = (int)syscall(__NR_io_uring_setup, buffer_amount, &params);
+
+    if(uring_fd < 0)
+        return SVRTY_URING_NOT_SUPPORTED;
+
+    // Writing at the current file position (required by stdout/pipes) is needed.
+    if(!(params.features & IORING_FEAT_RW_CUR_POS))
+    {
+        SeverityLogUringRelease();
+        return SVRTY_URING_NOT_SUPPORTED;
+    }
+
+    sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    if(params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if(cq_ring_size > sq_ring_size)
+            sq_ring_size = cq_ring_size;
+
+        cq_ring_size = sq_ring_size;
+    }
+
+    sq_ring_ptr = mmap(NULL, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring_fd, IORING_OFF_SQ_RING);
+
+    if(sq_ring_ptr == MAP_FAILED)
+    {
+        sq_ring_ptr = NULL;
+        SeverityLogUringRelease();
+        return SVRTY_URING_NOT_SUPPORTED;
+    }
+
+    if(params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        cq_ring_ptr = sq_ring_ptr;
+    }
+    else
+    {
+        cq_ring_ptr = mmap(NULL, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring_fd, IORING_OFF_CQ_RING);
+
+        if(cq_ring_ptr == MAP_FAILED)
+        {
+            cq_ring_ptr = NULL;
+            SeverityLogUringRelease();
+            return SVRTY_URING_NOT_SUPPORTED;
+        }
+    }
+
+    sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes = mmap(NULL, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring_fd, IORING_OFF_SQES);
+
+    if(sqes == MAP_FAILED)
+    {
+        sqes = NULL;
+        SeverityLogUringRelease();
+        return SVRTY_URING_NOT_SUPPORTED;
+    }
+
+    sq_tail     = (unsigned int*)((char*)sq_ring_ptr + params.sq_off.tail);
+    sq_mask     = (unsigned int*)((char*)sq_ring_ptr + params.sq_off.ring_mask);
+    sq_array    = (unsigned int*)((char*)sq_ring_ptr + params.sq_off.array);
+    cq_head     = (unsigned int*)((char*)cq_ring_ptr + params.cq_off.head);
+    cq_tail     = (unsigned int*)((char*)cq_ring_ptr + params.cq_off.tail);
+    cq_mask     = (unsigned int*)((char*)cq_ring_ptr + params.cq_off.ring_mask);
+    cqes        = (struct io_uring_cqe*)((char*)cq_ring_ptr + params.cq_off.cqes);
+
+    uring_buffer_amount = buffer_amount;
+    uring_buffer_size   = buffer_size;
+    uring_buffers       = (SVRTY_URING_BUF*)calloc(buffer_amount, sizeof(SVRTY_URING_BUF));
+    uring_buffers_memory= (char*)calloc(buffer_amount, buffer_size);
+    uring_chain         = (unsigned int*)calloc(buffer_amount, sizeof(unsigned int));
+    uring_queue         = (unsigned int*)calloc(buffer_amount, sizeof(unsigned int));
+
+    if(uring_buffers == NULL || uring_buffers_memory == NULL || uring_chain == NULL || uring_queue == NULL)
+    {
+        SeverityLogUringRelease();
+        return SVRTY_URING_ALLOCATION_ERR;
+    }
+
+    struct iovec* registered = (struct iovec*)calloc(buffer_amount, sizeof(struct iovec));
+
+    if(registered == NULL)
+    {
+        SeverityLogUringRelease();
+        return SVRTY_URING_ALLOCATION_ERR;
+    }
+
+    for(unsigned int i = 0; i < buffer_amount; i++)
+    {
+        uring_buffers[i].data   = uring_buffers_memory + (i * buffer_size);
+        uring_buffers[i].fd     = -1;
+        registered[i].iov_base  = uring_buffers[i].data;
+        registered[i].iov_len   = buffer_size;
+    }
+
+    // Registration may fail because of RLIMIT_MEMLOCK in older kernels. Plain writes are used then.
+    uring_buffers_registered = (syscall(__NR_io_uring_register, uring_fd, IORING_REGISTER_BUFFERS, registered, buffer_amount) == 0);
+
+    free(registered);
+
+    if(pthread_create(&uring_completer, NULL, SeverityLogUringCompleter, NULL) != 0)
+    {
+        SeverityLogUringRelease();
+        return SVRTY_URING_THREAD_ERR;
+    }
+
+    return SVRTY_URING_SUCCESS;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Copies data into registered buffers and submits them as asynchronous writes (or
+/// queues them, if writes from a previous call are still in flight). Never waits for I/O,
+/// unless every buffer is busy.
+/// @param fd Target file descriptor. Writes are performed at its current file position.
+/// @param iov Data to be written.
+/// @param iovcnt Number of elements in iov.
+/// @return 0 if succeeded, < 0 otherwise.
+//////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogUringWrite(const int fd, const struct iovec* iov, const int iovcnt)
+{
+    if(uring_fd < 0)
+        return SVRTY_URING_NOT_INITIALIZED;
+
+    pthread_mutex_lock(&uring_mtx);
+
+    int cur = -1;
+
+    for(int i = 0; i < iovcnt; i++)
+    {
+        const char* src = (const char*)iov[i].iov_base;
+        size_t left = iov[i].iov_len;
+
+        while(left > 0)
+        {
+            if(cur < 0)
+            {
+                cur = SeverityLogUringGetFreeBuffer();
+                uring_buffers[cur].fd = fd;
+            }
+
+            SVRTY_URING_BUF* buffer = &uring_buffers[cur];
+            size_t to_copy = uring_buffer_size - buffer->length;
+
+            if(to_copy > left)
+                to_copy = left;
+
+            memcpy(buffer->data + buffer->length, src, to_copy);
+
+            buffer->length  += to_copy;
+            src             += to_copy;
+            left            -= to_copy;
+
+            if(buffer->length == uring_buffer_size)
+            {
+                uring_queue[uring_queue_len++] = (unsigned int)cur;
+                cur = -1;
+            }
+        }
+    }
+
+    if(cur >= 0)
+    {
+        if(uring_buffers[cur].length > 0)
+            uring_queue[uring_queue_len++] = (unsigned int)cur;
+        else
+            uring_buffers[cur].busy = false;
+    }
+
+    // Every write produced by this call is submitted with a single system call, unless a chain is in flight.
+    SeverityLogUringSubmitQueue();
+
+    pthread_mutex_unlock(&uring_mtx);
+
+    return SVRTY_URING_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////
+/// @brief Waits until every submitted (or queued) write has completed.
+///////////////////////////////////////////////////////////////////////
+void SeverityLogUringFlush(void)
+{
+    if(uring_fd < 0)
+        return;
+
+    pthread_mutex_lock(&uring_mtx);
+
+    while(uring_chain_len > 0 || uring_queue_len > 0)
+    {
+        SeverityLogUringSubmitQueue();
+        pthread_cond_wait(&uring_cond, &uring_mtx);
+    }
+
+    pthread_mutex_unlock(&uring_mtx);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Releases every io_uring related resource, without waiting for pending writes.
+////////////////////////////////////////////////////////////////////////////////////////
+void SeverityLogUringRelease(void)
+{
+    // Completion thread is gone by now (or does not exist in the child), but it may have been waiting on it at fork.
+    pthread_cond_init(&uring_cond, NULL);
+
+    if(sqes != NULL)
+        munmap(sqes, sqes_size);
+
+    if(cq_ring_ptr != NULL && cq_ring_ptr != sq_ring_ptr)
+        munmap(cq_ring_ptr, cq_ring_size);
+
+    if(sq_ring_ptr != NULL)
+        munmap(sq_ring_ptr, sq_ring_size);
+
+    if(uring_fd >= 0)
+        close(uring_fd);
+
+    free(uring_buffers);
+    free(uring_buffers_memory);
+    free(uring_chain);
+    free(uring_queue);
+
+    uring_fd                    = -1;
+    sqes                        = NULL;
+    sq_ring_ptr                 = NULL;
+    cq_ring_ptr                 = NULL;
+    uring_buffers               = NULL;
+    uring_buffers_memory        = NULL;
+    uring_chain                 = NULL;
+    uring_chain_len             = 0;
+    uring_queue                 = NULL;
+    uring_queue_len             = 0;
+    uring_buffer_amount         = 0;
+    uring_buffers_registered    = false;
+    uring_in_flight             = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Takes the io_uring mutex, so that fork does not take place while the
+/// completion thread (or a logger) holds it. Released by SeverityLogUringUnlock
+/// (in both parent and child processes).
+////////////////////////////////////////////////////////////////////////////////
+void SeverityLogUringLock(void)
+{
+    pthread_mutex_lock(&uring_mtx);
+}
+
+////////////////////////////////////////////////////////////
+/// @brief Releases the mutex taken by SeverityLogUringLock.
+////////////////////////////////////////////////////////////
+void SeverityLogUringUnlock(void)
+{
+    pthread_mutex_unlock(&uring_mtx);
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+/// @brief Waits for pending writes, then releases io_uring instance and buffers.
+/////////////////////////////////////////////////////////////////////////////////
+void SeverityLogUringExit(void)
+{
+    if(uring_fd < 0)
+        return;
+
+    SeverityLogUringFlush();
+
+    // Completion thread leaves once it reaps this NOP's completion.
+    pthread_mutex_lock(&uring_mtx);
+
+    struct io_uring_sqe* sqe = SeverityLogUringNextSqe();
+
+    sqe->opcode     = IORING_OP_NOP;
+    sqe->user_data  = SVRTY_URING_STOP_DATA;
+
+    SeverityLogUringEnter(1, 0);
+
+    pthread_mutex_unlock(&uring_mtx);
+
+    pthread_join(uring_completer, NULL);
+
+    SeverityLogUringRelease();
+}
+
+/*************************************/
@@ -0,0 +1,66 @@
+#ifndef SEVERITY_LOG_URING_H
+#define SEVERITY_LOG_URING_H
+
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+/************************************/
+
+/*************************************/
+/******** Function prototypes ********/
+/*************************************/
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Sets up an io_uring instance alongside its registered output buffers.
+/// @param buffer_amount Number of registered buffers (maximum amount of writes in flight).
+/// @param buffer_size Size of each registered buffer.
+/// @return 0 if succeeded, < 0 if io_uring is not supported (or allocation failed).
+///////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogUringInit(const unsigned int buffer_amount, const size_t buffer_size);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Copies data into registered buffers and submits them as asynchronous writes (or
+/// queues them, if writes from a previous call are still in flight). Never waits for I/O,
+/// unless every buffer is busy.
+/// @param fd Target file descriptor. Writes are performed at its current file position.
+/// @param iov Data to be written.
+/// @param iovcnt Number of elements in iov.
+/// @return 0 if succeeded, < 0 otherwise.
+//////////////////////////////////////////////////////////////////////////////////////////
+int SeverityLogUringWrite(const int fd, const struct iovec* iov, const int iovcnt);
+
+///////////////////////////////////////////////////////////////////////
+/// @brief Waits until every submitted (or queued) write has completed.
+///////////////////////////////////////////////////////////////////////
+void SeverityLogUringFlush(void);
+
+////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Releases every io_uring related resource, without waiting for pending writes.
+/// Meant to be used by child processes, which must not use their parent's instance.
+////////////////////////////////////////////////////////////////////////////////////////
+void SeverityLogUringRelease(void);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Takes the io_uring mutex, so that fork does not take place while the
+/// completion thread (or a logger) holds it. Released by SeverityLogUringUnlock
+/// (in both parent and child processes).
+////////////////////////////////////////////////////////////////////////////////
+void SeverityLogUringLock(void);
+
+////////////////////////////////////////////////////////////
+/// @brief Releases the mutex taken by SeverityLogUringLock.
+////////////////////////////////////////////////////////////
+void SeverityLogUringUnlock(void);
+
+/////////////////////////////////////////////////////////////////////////////////
+/// @brief Waits for pending writes, then releases io_uring instance and buffers.
+/////////////////////////////////////////////////////////////////////////////////
+void SeverityLogUringExit(void);
+
+/*************************************/
+
+#endif
@@ -40,8 +40,52 @@ extern "C" {
 #define SVRTY_LOG_MASK_EIW  0b0111 // EIW stands for ERR, INF, WNG
 #define SVRTY_LOG_MASK_ALL  0b1111
 
+#define SVRTY_LOG_BACKEND_STDIO     0   // printf + fflush (default).
+#define SVRTY_LOG_BACKEND_WRITEV    1   // A single writev per log/batch, no intermediate copies.
+#define SVRTY_LOG_BACKEND_IO_URING  2   // Asynchronous writes through io_uring (falls back to writev).
+
+#define SVRTY_LOG_FILE_COMPRESSION_NONE 0   // Blocks are stored as they are.
+#define SVRTY_LOG_FILE_COMPRESSION_LZ   1   // Blocks are compressed (LZ77, built-in) on the file writer thread.
+
+#define SVRTY_LOG_OVERFLOW_BLOCK    0   // Loggers wait for the writer thread when their staging buffer is full (default).
+#define SVRTY_LOG_OVERFLOW_DROP     1   // INF and DBG logs are dropped when their staging buffer is full. ERR and WNG never are.
+
+#define SVRTY_LOG_BATCH_FULL        -7  // Log does not fit in the batch: commit it, then append the log again.
+
+#define SVRTY_LOG_SPAN_CONCAT_IMPL(A, B)    A##B
+#define SVRTY_LOG_SPAN_CONCAT(A, B)         SVRTY_LOG_SPAN_CONCAT_IMPL(A, B)
+
 /***********************************/
 
+/**********************************/
+/******** Type definitions ********/
+/**********************************/
+
+/// @brief Timing span. Only meant to be handled by SeverityLogSpanBegin/SeverityLogSpanEnd (and related macros).
+typedef struct
+{
+    const char* name        ;   // Span name, printed alongside the elapsed time.
+    uint8_t     severity    ;   // Severity level the span will be logged with.
+    uint64_t    start_ns    ;   // CLOCK_MONOTONIC start time (0 if the span is disabled).
+} SVRTY_LOG_SPAN;
+
+/// @brief Batch of logs. Only meant to be handled by SeverityLogBatchBegin/Append/Commit.
+typedef struct
+{
+    char*   buffer          ;   // Caller-owned buffer in which logs are accumulated.
+    size_t  buffer_size     ;   // Caller-owned buffer size.
+    size_t  length          ;   // Amount of bytes currently in use.
+    size_t  payload_length  ;   // Same, but line feeds separating logs are not counted.
+    uint8_t severity        ;   // Severity level shared by every log in the batch.
+    int     status          ;   // < 0 if the batch is not meant to be printed (masked level, sampled out, wrong buffer...).
+} SVRTY_LOG_BATCH;
+
+/// @brief Capture sink callback (see SetSeverityLogCaptureSink). Called once per line, with the line as printed to stdout
+/// (without colors nor line feed), while holding the output mutex: lines of a single log are always delivered in a row.
+typedef void (*SVRTY_LOG_CAPTURE_CALLBACK)(const uint8_t severity, const char* line, const size_t line_len, void* user_data);
+
+/**********************************/
+
 /*************************************/
 /******** Function prototypes ********/
 /*************************************/
@@ -113,6 +157,117 @@ C_SEVERITY_LOG_API int SeverityLogInit( const size_t buffer_size            ,
                                         const bool print_TID                ,
                                         const bool log_to_syslog            );
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Sets the sampling rate for a given severity level (1 out of N logs is kept).
+/// Sampled levels include the rate in every emitted line ("[1/N] "), so counts can be re-weighted.
+/// @param severity Target severity level.
+/// @param rate Target sampling rate (0 or 1 disable sampling).
+/// @return 0 if succeeded, < 0 if an invalid severity level was provided.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SetSeverityLogSamplingRate(const uint8_t severity, const uint32_t rate);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Selects how logs are written to stdout.
+/// @param backend SVRTY_LOG_BACKEND_STDIO, SVRTY_LOG_BACKEND_WRITEV or SVRTY_LOG_BACKEND_IO_URING.
+/// @return Backend actually in use (io_uring falls back to writev if it is not supported),
+/// < 0 if an invalid backend was provided.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SetSeverityLogOutputBackend(const uint8_t backend);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Publishes logs into a named shared memory ring, from which a collector process
+/// can consume them (see SeverityLogShm_api.h). If the ring already exists, it is attached
+/// to as it is, so several processes can share it.
+/// @param name Shared memory object name (i.e. "/my_log"). NULL detaches from the ring.
+/// @param slot_amount Number of slots (rounded up to a power of two).
+/// @param slot_size Size of each slot, 32 byte record header included (rounded up to a multiple of 64).
+/// @return 0 if succeeded, < 0 otherwise.
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SetSeverityLogShmSink(const char* name, const uint32_t slot_amount, const uint32_t slot_size);
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Writes logs into a file, in independently compressed blocks followed by a block index,
+/// so that any time range can be read without decompressing the whole file (see
+/// SeverityLogFile_api.h and svrty_cat tool). Blocks are compressed by a writer thread.
+/// @param path File path (truncated if it exists). NULL closes the current file.
+/// @param compression SVRTY_LOG_FILE_COMPRESSION_NONE or SVRTY_LOG_FILE_COMPRESSION_LZ.
+/// @param block_size Maximum block size, before compression (0 sets the default one, 64 KB).
+/// @return 0 if succeeded, < 0 otherwise.
+/////////////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SetSeverityLogFileSink(const char* path, const uint8_t compression, const size_t block_size);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Makes file sinks write a sparse sidecar index (<path>.idx) alongside the log file, with
+/// an entry (timestamp, block, offset within the block and severity levels found) every given
+/// number of records or bytes. Time range queries (see svrty_query tool) binary search it rather
+/// than scanning the file, even if the file is still being written. Applies to files opened
+/// afterwards (see SetSeverityLogFileSink). Both set to 0 (default) disables it.
+/// @param record_interval Records per index entry, at most (0: no limit).
+/// @param byte_interval Bytes per index entry (before compression), at most (0: no limit).
+//////////////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API void SetSeverityLogFileSidecarIndex(const uint32_t record_interval, const uint32_t byte_interval);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Gets the number of INF and DBG records dropped from the current file sink under
+/// SVRTY_LOG_OVERFLOW_DROP because its writer thread fell too far behind (loggers never
+/// wait for compression or disk I/O).
+/// @return Number of dropped records.
+//////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API uint64_t SeverityLogGetFileDroppedCount(void);
+
+////////////////////////////////////////////////////////////////////////
+/// @brief Sets whether logs are printed to stdout. Other sinks (syslog,
+/// shared memory ring, file) are not affected.
+/// @param stdout_status Print to stdout (T/F).
+////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API void SetSeverityLogStdoutStatus(const bool stdout_status);
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Hands every line over to a callback, alongside the rest of sinks (meant for tests and
+/// in-process collectors). Callbacks must not log, nor take locks held by logging threads.
+/// @param callback Target callback (see SVRTY_LOG_CAPTURE_CALLBACK). NULL disables capturing.
+/// @param user_data Provided to the callback as it is.
+////////////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API void SetSeverityLogCaptureSink(SVRTY_LOG_CAPTURE_CALLBACK callback, void* user_data);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Stages logs into per-CPU buffers instead of printing them under a single mutex. A
+/// writer thread drains them, merging records by timestamp so that output order is preserved.
+/// @param enable Enable (T) or disable (F, every staged log is printed before returning).
+/// @param segment_size Size of each CPU's staging buffer (0 sets the default one).
+/// @param writer_cpus CPUs the writer thread is pinned to (NULL does not pin it).
+/// @param writer_cpu_amount Number of elements in writer_cpus.
+/// @return 0 if succeeded, < 0 otherwise.
+//////////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SetSeverityLogPerCpuStaging(const bool enable, const size_t segment_size, const int* writer_cpus, const size_t writer_cpu_amount);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Makes sure every log printed so far has reached stdout (that includes
+/// waiting for asynchronous writes when using io_uring backend).
+////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API void SeverityLogFlush(void);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Selects what happens to INF and DBG logs when their per-CPU staging buffer is full.
+/// ERR and WNG logs are staged apart (and drained first), so they are never dropped.
+/// @param policy SVRTY_LOG_OVERFLOW_BLOCK or SVRTY_LOG_OVERFLOW_DROP.
+/// @return 0 if succeeded, < 0 if an invalid policy was provided.
+//////////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SetSeverityLogOverflowPolicy(const uint8_t policy);
+
+/////////////////////////////////////////////////////////////////////////////////////
+/// @brief Sets whether ERR logs return only once they have reached stdout, even when
+/// they are staged or written asynchronously (io_uring backend).
+/// @param sync_flush_status Flush ERR logs synchronously (T/F).
+/////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API void SetSeverityLogErrSyncFlush(const bool sync_flush_status);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @brief Gets the number of logs dropped because of SVRTY_LOG_OVERFLOW_DROP.
+/// @return Number of dropped logs.
+//////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API uint64_t SeverityLogGetDroppedCount(void);
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// @brief Tells whether names used to order libraries should be ignored or not when printing calling file name.
 /// @param ignore_lead_nums Ignore library name's leading numbers (after "lib").
@@ -133,6 +288,140 @@ C_SEVERITY_LOG_API int SeverityLog(const uint8_t severity, const char* C_SEVERIT
 #define SVRTY_LOG_WNG(...) SeverityLog(SVRTY_LVL_WNG, __VA_ARGS__)
 #define SVRTY_LOG_DBG(...) SeverityLog(SVRTY_LVL_DBG, __VA_ARGS__)
 
+/////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Prints an already formatted log. Same as SeverityLog, but no format is parsed.
+/// @param severity Severity level (ERR, INF, WNG, DBG).
+/// @param payload Log payload. It does not need to be null-terminated.
+/// @param payload_len Payload length.
+/// @return < 0 if any error happened, number of payload characters printed otherwise.
+/////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SeverityLogStr(const uint8_t severity, const char* payload, const size_t payload_len);
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Performs every check SeverityLog does before formatting (sampling included) and,
+/// if the log has to be printed, lends calling thread's log buffer so that the payload can
+/// be written straight into it. Payload is printed by SeverityLogCommit.
+/// @param severity Severity level (ERR, INF, WNG, DBG).
+/// @param payload Set to calling thread's log buffer.
+/// @param payload_capacity Set to the maximum payload length (same limit as SeverityLog's).
+/// @return 0 if the log has to be printed, < 0 otherwise (nothing has to be committed then).
+/////////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SeverityLogReserve(const uint8_t severity, char** payload, size_t* payload_capacity);
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Prints a payload written into the buffer lent by SeverityLogReserve. Nothing else
+/// may be logged by the calling thread in between.
+/// @param severity Severity level (same as the one provided to SeverityLogReserve).
+/// @param payload_len Payload length.
+/// @return < 0 if any error happened, number of payload characters printed otherwise.
+////////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SeverityLogCommit(const uint8_t severity, const size_t payload_len);
+
+///////////////////////////////////////////////////////////////////////////////////////
+/// @brief Tells whether or not a log with the given severity level would be printed.
+/// Sampling is not taken into account (SeverityLogReserve does, as it draws a sample).
+/// @param severity Target severity level.
+/// @return true if the library is initialized and the severity level is not masked.
+///////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API bool SeverityLogLevelEnabled(const uint8_t severity);
+
+/////////////////////////////////////////////////////////////////////////////////
+/// @brief Sets the minimum duration a span must last for it to be logged.
+/// @param threshold_ns Minimum span duration in nanoseconds (0 logs every span).
+/////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API void SetSeverityLogSpanThreshold(const uint64_t threshold_ns);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Tells whether or not a span with the given severity level gets timed.
+/// @param severity Target severity level.
+/// @return true if the library is initialized and the severity level is valid
+/// and not masked.
+////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API bool SeverityLogSpanEnabled(const uint8_t severity);
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Starts a timing span. Time is only sampled if the severity level is not masked.
+/// @param severity Severity level the span will be logged with.
+/// @param name Span name. Must outlive the span itself (string literals are the usual choice).
+/// @return Span to be handed to SeverityLogSpanEnd.
+///////////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API SVRTY_LOG_SPAN SeverityLogSpanBegin(const uint8_t severity, const char* name);
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Ends a timing span, logging its duration if it exceeds the configured threshold.
+/// @param span Target span, as returned by SeverityLogSpanBegin.
+/// @return < 0 if nothing was logged, number of characters written to stream otherwise.
+///////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SeverityLogSpanEnd(SVRTY_LOG_SPAN* span);
+
+#define SVRTY_LOG_SPAN_BEGIN(span, level, name) SVRTY_LOG_SPAN span = SeverityLogSpanBegin(level, name)
+#define SVRTY_LOG_SPAN_END(span)                SeverityLogSpanEnd(&(span))
+
+// Times the enclosing scope, logging its duration when the scope is left.
+#define SVRTY_LOG_SCOPE_TIMER(level, name)                                                  \
+    SVRTY_LOG_SPAN SVRTY_LOG_SPAN_CONCAT(svrty_log_scope_span_, __LINE__)                   \
+    __attribute__((cleanup(SeverityLogSpanEnd))) = SeverityLogSpanBegin(level, name)
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Pushes a key/value pair into calling thread's logging context. Every log printed by
+/// the thread includes its context after the TID. Context is rendered here, rather than
+/// every time a log is printed.
+/// @param key Context key (i.e. "req").
+/// @param value Context value.
+/// @return 0 if succeeded, < 0 if the context is full.
+//////////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SeverityLogContextPush(const char* key, const char* value);
+
+////////////////////////////////////////////////////////////////////
+/// @brief Pops the last key/value pair pushed into calling thread's
+/// logging context.
+/// @return 0 if succeeded, < 0 if the context was already empty.
+////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SeverityLogContextPop(void);
+
+//////////////////////////////////////////////////////////////////////////////
+/// @brief Pops a context pushed by SVRTY_LOG_CONTEXT_SCOPE, if it was pushed.
+/// @param push_result Result of the matching SeverityLogContextPush call.
+//////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API void SeverityLogContextScopeEnd(int* push_result);
+
+// Adds a key/value pair to calling thread's logging context until the enclosing scope is left.
+#define SVRTY_LOG_CONTEXT_SCOPE(key, value)                                                 \
+    int SVRTY_LOG_SPAN_CONCAT(svrty_log_scope_context_, __LINE__)                           \
+    __attribute__((cleanup(SeverityLogContextScopeEnd))) = SeverityLogContextPush(key, value)
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Starts a batch of logs sharing the same severity level, prefix and timestamp.
+/// If sampling is enabled for the severity level, it is decided here for the whole batch.
+/// @param batch Target batch.
+/// @param severity Severity level of every log in the batch.
+/// @param buffer Caller-owned buffer in which logs are accumulated until commit.
+/// @param buffer_size Caller-owned buffer size.
+/// @return 0 if succeeded, < 0 otherwise (for instance, if the severity level is masked or
+/// the batch is sampled out). Appending to and committing the batch returns the same then.
+///////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SeverityLogBatchBegin(SVRTY_LOG_BATCH* batch, const uint8_t severity, char* buffer, const size_t buffer_size);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Appends a log to a batch. Nothing is printed until the batch is committed.
+/// @param batch Target batch, as initialized by SeverityLogBatchBegin.
+/// @param format Formatted string. Same as what can be used with printf.
+/// @param ... Variable number of arguments. Data that is meant to be formatted and printed.
+/// @return SVRTY_LOG_BATCH_FULL if the log does not fit (commit the batch, then append it again), another
+/// value < 0 if the batch is not meant to be printed (see SeverityLogBatchBegin), number of appended
+/// characters otherwise.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SeverityLogBatchAppend(SVRTY_LOG_BATCH* batch, const char* C_SEVERITY_LOG_RESTRICT format, ...);
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Prints every log accumulated in a batch by using a single lock and a single flush.
+/// Every line gets the same prefix as SeverityLog would print. The batch is emptied afterwards.
+/// @param batch Target batch, as initialized by SeverityLogBatchBegin.
+/// @return < 0 if any error happened, number of payload characters printed otherwise (the sum of
+/// every SeverityLogBatchAppend result, line feeds separating logs excluded).
+/////////////////////////////////////////////////////////////////////////////////////////////////
+C_SEVERITY_LOG_API int SeverityLogBatchCommit(SVRTY_LOG_BATCH* batch);
+
 /*************************************/
 
 #ifdef __cplusplus
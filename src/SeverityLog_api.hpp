@@ -0,0 +1,281 @@
+#ifndef SEVERITY_LOG_API_HPP
+#define SEVERITY_LOG_API_HPP
+
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "SeverityLog_api.h"
+
+/************************************/
+
+/***********************************/
+/******** Define statements ********/
+/***********************************/
+
+// Wraps a string literal so that its placeholders ("{}") can be checked against arguments at compile time.
+#define SVRTY_FMT(fmt_str)                                                          \
+    []                                                                              \
+    {                                                                               \
+        struct SvrtyFmt : ::svrty::detail::FormatString                             \
+        {                                                                           \
+            static constexpr std::string_view Value() { return fmt_str; }           \
+        };                                                                          \
+        return SvrtyFmt{};                                                          \
+    }()
+
+/***********************************/
+
+/*************************************/
+/******** Private definitions ********/
+/*************************************/
+
+namespace svrty
+{
+namespace detail
+{
+
+/// @brief Base type of every format string built by SVRTY_FMT.
+struct FormatString {};
+
+constexpr std::size_t BAD_FORMAT = static_cast<std::size_t>(-1);
+
+////////////////////////////////////////////////////////////////////////////////////
+/// @brief Counts placeholders ("{}") in a format string. "{{" and "}}" are escapes.
+/// @param fmt Target format string.
+/// @return Number of placeholders, BAD_FORMAT if any brace is unmatched.
+////////////////////////////////////////////////////////////////////////////////////
+constexpr std::size_t CountPlaceholders(const std::string_view fmt)
+{
+    std::size_t count = 0;
+
+    for(std::size_t i = 0; i < fmt.size(); i++)
+    {
+        const bool has_next = (i + 1 < fmt.size());
+
+        if(fmt[i] == '{')
+        {
+            if(!has_next || (fmt[i + 1] != '{' && fmt[i + 1] != '}'))
+                return BAD_FORMAT;
+
+            count += (fmt[i + 1] == '}' ? 1 : 0);
+            ++i;
+        }
+        else if(fmt[i] == '}')
+        {
+            if(!has_next || fmt[i + 1] != '}')
+                return BAD_FORMAT;
+
+            ++i;
+        }
+    }
+
+    return count;
+}
+
+template <typename T>
+using Decayed = std::remove_cv_t<std::remove_reference_t<T>>;
+
+template <typename T>
+constexpr bool IsString =   std::is_same_v<Decayed<T>, std::string_view>   ||
+                            std::is_same_v<Decayed<T>, std::string>        ||
+                            std::is_same_v<std::decay_t<T>, const char*>   ||
+                            std::is_same_v<std::decay_t<T>, char*>         ;
+
+template <typename T>
+constexpr bool IsFormattable =  IsString<T>                                 ||
+                                std::is_arithmetic_v<Decayed<T>>            ||
+                                std::is_enum_v<Decayed<T>>                  ||
+                                std::is_pointer_v<std::decay_t<T>>          ;
+
+/// @brief Bounded writer over calling thread's log buffer. Silently truncates once full.
+class Writer
+{
+public:
+    Writer(char* begin, char* end) : cur_(begin), begin_(begin), end_(end) {}
+
+    void Put(const std::string_view str)
+    {
+        const std::size_t len = std::min(str.size(), static_cast<std::size_t>(end_ - cur_));
+        str.copy(cur_, len);
+        cur_ += len;
+    }
+
+    template <typename T>
+    void Put(const T& value)
+    {
+        using V = Decayed<T>;
+
+        if constexpr(IsString<T> && std::is_pointer_v<std::decay_t<T>>)
+        {
+            // Same as printf does with null strings (std::string_view would not even take them).
+            const char* str = value;
+            Put(str != nullptr ? std::string_view(str) : std::string_view("(null)"));
+        }
+        else if constexpr(IsString<T>)
+        {
+            Put(std::string_view(value));
+        }
+        else if constexpr(std::is_same_v<V, bool>)
+        {
+            Put(value ? std::string_view("true") : std::string_view("false"));
+        }
+        else if constexpr(std::is_same_v<V, char>)
+        {
+            Put(std::string_view(&value, 1));
+        }
+        else if constexpr(std::is_enum_v<V>)
+        {
+            Put(static_cast<std::underlying_type_t<V>>(value));
+        }
+        else if constexpr(std::is_arithmetic_v<V>)
+        {
+            const std::to_chars_result result = std::to_chars(cur_, end_, value);
+            cur_ = (result.ec == std::errc() ? result.ptr : end_);
+        }
+        else
+        {
+            Put(std::string_view("0x"));
+            const std::to_chars_result result = std::to_chars(cur_, end_, reinterpret_cast<std::uintptr_t>(value), 16);
+            cur_ = (result.ec == std::errc() ? result.ptr : end_);
+        }
+    }
+
+    std::size_t Length(void) const { return static_cast<std::size_t>(cur_ - begin_); }
+
+private:
+    char* cur_  ;
+    char* begin_;
+    char* end_  ;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Writes format string's literal text until the next placeholder (unescaping braces).
+/// @param writer Target writer.
+/// @param fmt Remaining format string.
+/// @return Format string right after the placeholder (empty if there was none).
+//////////////////////////////////////////////////////////////////////////////////////////////
+inline std::string_view PutUntilPlaceholder(Writer& writer, std::string_view fmt)
+{
+    std::size_t i = 0;
+
+    while(i < fmt.size())
+    {
+        if(fmt[i] == '{' || fmt[i] == '}')
+        {
+            writer.Put(fmt.substr(0, i));
+
+            // Placeholder found.
+            if(fmt[i] == '{' && fmt[i + 1] == '}')
+                return fmt.substr(i + 2);
+
+            // Escaped brace: write only one of both.
+            writer.Put(fmt.substr(i, 1));
+            fmt = fmt.substr(i + 2);
+            i = 0;
+            continue;
+        }
+
+        ++i;
+    }
+
+    writer.Put(fmt);
+
+    return std::string_view();
+}
+
+inline void Format(Writer& writer, const std::string_view fmt)
+{
+    PutUntilPlaceholder(writer, fmt);
+}
+
+template <typename First, typename... Rest>
+void Format(Writer& writer, const std::string_view fmt, const First& first, const Rest&... rest)
+{
+    const std::string_view remaining = PutUntilPlaceholder(writer, fmt);
+    writer.Put(first);
+    Format(writer, remaining, rest...);
+}
+
+template <typename Fmt>
+using EnableIfFormat = std::enable_if_t<std::is_base_of_v<FormatString, Fmt>, int>;
+
+} // namespace detail
+
+/*************************************/
+
+/**********************************/
+/******** Public functions ********/
+/**********************************/
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Formats a log (without varargs) and prints it through the same path as SeverityLog.
+/// Placeholder count and argument types are checked at compile time. Same length limit applies.
+/// @param severity Severity level (ERR, INF, WNG, DBG).
+/// @param fmt Format string, as built by SVRTY_FMT("...").
+/// @param args Arguments. Strings, string views, arithmetic types, enums and pointers are supported.
+/// @return < 0 if any error happened, number of payload characters printed otherwise.
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Fmt, typename... Args, detail::EnableIfFormat<Fmt> = 0>
+int log(const uint8_t severity, Fmt, const Args&... args)
+{
+    static_assert(detail::CountPlaceholders(Fmt::Value()) != detail::BAD_FORMAT, "Unmatched brace in log format string.");
+    static_assert(detail::CountPlaceholders(Fmt::Value()) == sizeof...(Args), "Placeholder count does not match argument count.");
+    static_assert((detail::IsFormattable<Args> && ...), "Unsupported log argument type.");
+
+    char*       payload             = nullptr;
+    std::size_t payload_capacity    = 0;
+
+    // Nothing is formatted if the log is not going to be printed anyway (masked or sampled out).
+    const int reserved = SeverityLogReserve(severity, &payload, &payload_capacity);
+
+    if(reserved < 0)
+        return reserved;
+
+    // Arguments are formatted straight into the library's buffer, so nothing is copied afterwards.
+    detail::Writer writer(payload, payload + payload_capacity);
+    detail::Format(writer, Fmt::Value(), args...);
+
+    return SeverityLogCommit(severity, writer.Length());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Prints an unformatted payload. It is copied once, into calling thread's log buffer.
+/// @param severity Severity level (ERR, INF, WNG, DBG).
+/// @param payload Target payload.
+/// @return < 0 if any error happened, number of payload characters printed otherwise.
+//////////////////////////////////////////////////////////////////////////////////////////////
+inline int log(const uint8_t severity, const std::string_view payload)
+{
+    return SeverityLogStr(severity, payload.data(), payload.size());
+}
+
+template <typename Fmt, typename... Args, detail::EnableIfFormat<Fmt> = 0>
+int err(Fmt fmt, const Args&... args) { return log(SVRTY_LVL_ERR, fmt, args...); }
+
+template <typename Fmt, typename... Args, detail::EnableIfFormat<Fmt> = 0>
+int inf(Fmt fmt, const Args&... args) { return log(SVRTY_LVL_INF, fmt, args...); }
+
+template <typename Fmt, typename... Args, detail::EnableIfFormat<Fmt> = 0>
+int wng(Fmt fmt, const Args&... args) { return log(SVRTY_LVL_WNG, fmt, args...); }
+
+template <typename Fmt, typename... Args, detail::EnableIfFormat<Fmt> = 0>
+int dbg(Fmt fmt, const Args&... args) { return log(SVRTY_LVL_DBG, fmt, args...); }
+
+inline int err(const std::string_view payload) { return log(SVRTY_LVL_ERR, payload); }
+inline int inf(const std::string_view payload) { return log(SVRTY_LVL_INF, payload); }
+inline int wng(const std::string_view payload) { return log(SVRTY_LVL_WNG, payload); }
+inline int dbg(const std::string_view payload) { return log(SVRTY_LVL_DBG, payload); }
+
+} // namespace svrty
+
+/**********************************/
+
+#endif
@@ -0,0 +1,89 @@
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include "SeverityLog_api.hpp"
+
+/************************************/
+
+/***********************************/
+/******** Define statements ********/
+/***********************************/
+
+#define BENCH_LOG_BUFFER_SIZE   1000
+#define BENCH_LOG_INIT_MASK     0xF0
+#define BENCH_ITERATIONS        200000
+#define BENCH_NULL_DEVICE       "/dev/null"
+#define BENCH_RESULT_FORMAT     "%-28s %10.1f ns/log\n"
+
+/***********************************/
+
+/*************************************/
+/******* Function definitions ********/
+/*************************************/
+
+//////////////////////////////////////////////////////////////////
+/// @brief Runs a logging function many times and measures it.
+/// @param name Benchmark name, printed alongside the result.
+/// @param log_function Function logging a single message.
+//////////////////////////////////////////////////////////////////
+template <typename F>
+void RunBenchmark(const char* name, F log_function)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    for(int i = 0; i < BENCH_ITERATIONS; i++)
+        log_function(i);
+
+    const auto end = std::chrono::steady_clock::now();
+    const double elapsed_ns = std::chrono::duration<double, std::nano>(end - start).count();
+
+    fprintf(stderr, BENCH_RESULT_FORMAT, name, elapsed_ns / BENCH_ITERATIONS);
+}
+
+int main()
+{
+    const std::string   user_name   = "bench_user";
+    const double        ratio       = 0.75;
+
+    // Results are printed to stderr, logs are discarded.
+    if(freopen(BENCH_NULL_DEVICE, "w", stdout) == nullptr)
+        return -1;
+
+    SeverityLogInitWithMask(BENCH_LOG_BUFFER_SIZE, BENCH_LOG_INIT_MASK);
+
+    RunBenchmark("C SeverityLog", [&](int i)
+    {
+        SVRTY_LOG_INF("Request %d from <%s> ratio %f", i, user_name.c_str(), ratio);
+    });
+
+    RunBenchmark("C++ svrty::inf", [&](int i)
+    {
+        svrty::inf(SVRTY_FMT("Request {} from <{}> ratio {}"), i, user_name, ratio);
+    });
+
+    RunBenchmark("C++ svrty::inf (string_view)", [&](int)
+    {
+        svrty::inf(std::string_view(user_name));
+    });
+
+    SetSeverityLogMask(SVRTY_LOG_MASK_ERR);
+
+    RunBenchmark("C SeverityLog (masked)", [&](int i)
+    {
+        SVRTY_LOG_DBG("Request %d from <%s> ratio %f", i, user_name.c_str(), ratio);
+    });
+
+    RunBenchmark("C++ svrty::dbg (masked)", [&](int i)
+    {
+        svrty::dbg(SVRTY_FMT("Request {} from <{}> ratio {}"), i, user_name, ratio);
+    });
+
+    return 0;
+}
+
+/*************************************/
@@ -0,0 +1,94 @@
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include "SeverityLog_api.h"
+
+/************************************/
+
+/***********************************/
+/******** Define statements ********/
+/***********************************/
+
+#define BENCH_LOG_BUFFER_SIZE   1000
+#define BENCH_LOG_INIT_MASK     0xFA    // Every level, time and TID. No exe file name (backtraces would dominate), no syslog.
+#define BENCH_LOGS_PER_THREAD   5000
+#define BENCH_MAX_THREADS       256
+#define BENCH_NULL_DEVICE       "/dev/null"
+#define BENCH_RESULT_FORMAT     "%-18s %4d threads %12.0f logs/s %10.1f ns/log\n"
+#define BENCH_NS_PER_SEC        1000000000.0
+
+/***********************************/
+
+/*************************************/
+/******* Function definitions ********/
+/*************************************/
+
+/// @brief Logs BENCH_LOGS_PER_THREAD messages.
+static void* BenchThread(void* arg)
+{
+    long thread_idx = (long)arg;
+
+    for(int i = 0; i < BENCH_LOGS_PER_THREAD; i++)
+        SVRTY_LOG_INF("Thread %ld processed request %d", thread_idx, i);
+
+    return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////
+/// @brief Logs from many threads at once, and measures it (from the first
+/// log until every log has been written).
+/// @param name Benchmark name, printed alongside the result.
+/// @param thread_amount Number of logging threads.
+///////////////////////////////////////////////////////////////////////////
+static void RunBenchmark(const char* name, const int thread_amount)
+{
+    pthread_t threads[BENCH_MAX_THREADS];
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for(long i = 0; i < thread_amount; i++)
+        pthread_create(&threads[i], NULL, BenchThread, (void*)i);
+
+    for(int i = 0; i < thread_amount; i++)
+        pthread_join(threads[i], NULL);
+
+    SeverityLogFlush();
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsed_ns   = ((end.tv_sec - start.tv_sec) * BENCH_NS_PER_SEC) + (end.tv_nsec - start.tv_nsec);
+    double log_amount   = (double)thread_amount * BENCH_LOGS_PER_THREAD;
+
+    fprintf(stderr, BENCH_RESULT_FORMAT, name, thread_amount, log_amount * BENCH_NS_PER_SEC / elapsed_ns, elapsed_ns / log_amount);
+}
+
+int main()
+{
+    int thread_amounts[] = {1, 8, 64, 128};
+
+    // Results are printed to stderr, logs are discarded.
+    if(freopen(BENCH_NULL_DEVICE, "w", stdout) == NULL)
+        return -1;
+
+    SeverityLogInitWithMask(BENCH_LOG_BUFFER_SIZE, BENCH_LOG_INIT_MASK);
+
+    for(size_t i = 0; i < (sizeof(thread_amounts) / sizeof(thread_amounts[0])); i++)
+    {
+        RunBenchmark("Shared mutex", thread_amounts[i]);
+
+        SetSeverityLogPerCpuStaging(true, 0, NULL, 0);
+        RunBenchmark("Per-CPU staging", thread_amounts[i]);
+        SetSeverityLogPerCpuStaging(false, 0, NULL, 0);
+    }
+
+    return 0;
+}
+
+/*************************************/
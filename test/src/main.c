@@ -2,7 +2,15 @@
 /******** Include statements ********/
 /************************************/
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
 #include "SeverityLog_api.h"
+#include "SeverityLogShm_api.h"
+#include "SeverityLogFile_api.h"
 
 /************************************/
 
@@ -22,6 +30,101 @@
 #define TEST_MSG_MULTIPLE_LINES_HEADER  "******** TESTING LOGS WITH MULTIPLE LINES ********"
 #define TEST_MSG_MULTIPLE_LINES         "This is line 1\nThis is line 2\r\nThis is line 3"
 
+#define TEST_MSG_SPAN_HEADER    "******** TESTING TIMING SPANS ********"
+#define TEST_MSG_SPAN_NAME      "test span"
+#define TEST_MSG_SCOPE_NAME     "test scope"
+#define TEST_SPAN_LOOPS         100000
+#define TEST_SPAN_THRESHOLD_NS  (3600 * 1000000000ULL)  // No span in this test lasts that long.
+#define TEST_MSG_SPAN_RESULT    "Span results: masked %d (< 0 expected) with %d line(s) captured (0 expected), below threshold %d (< 0 expected), logged %d (> 0 expected). Scope timers logged %d line(s) (1 expected). Level 0 spans enabled: %d (0 expected)."
+
+#define TEST_MSG_SAMPLING_HEADER    "******** TESTING SAMPLING ********"
+#define TEST_MSG_SAMPLING           "Sampled message %d."
+#define TEST_SAMPLING_RATE          10
+#define TEST_SAMPLING_LOGS          100
+#define TEST_MSG_SAMPLING_RESULT    "%d out of %d sampled messages were printed."
+
+#define TEST_MSG_BATCH_HEADER   "******** TESTING BATCHES ********"
+#define TEST_MSG_BATCH_ROW      "Row %d: value = %d"
+#define TEST_MSG_BATCH_RESULT   "Batch commits printed %d payload characters (%d appended)."
+#define TEST_MSG_BATCH_SAMPLED  "%d out of %d sampled batches were printed, %d of them partially (0 expected)."
+#define TEST_BATCH_BUFFER_SIZE  256
+#define TEST_BATCH_ROWS         20
+#define TEST_BATCH_SAMPLED_ROWS 2
+
+#define TEST_MSG_BACKEND_HEADER "******** TESTING OUTPUT BACKENDS ********"
+#define TEST_MSG_BACKEND        "Printed through backend %d.\nSecond line."
+
+#define TEST_MSG_PIPE_HEADER    "******** TESTING SHORT WRITES (FULL PIPE) ********"
+#define TEST_MSG_PIPE           "Pipe record %d %s"
+#define TEST_MSG_PIPE_RECORD    "Pipe record "
+#define TEST_MSG_PIPE_RESULT    "%d out of %d records were read back intact and in order through backend %d."
+#define TEST_PIPE_LOGS          100
+#define TEST_PIPE_BUFFER_SIZE   (16 * 1024) // Writes larger than a page can be partially accepted by a full pipe.
+#define TEST_PIPE_PADDING_LEN   (12 * 1024)
+#define TEST_PIPE_PADDING_CHAR  'x'
+#define TEST_PIPE_OUTPUT_SIZE   (TEST_PIPE_LOGS * TEST_PIPE_BUFFER_SIZE)
+#define TEST_PIPE_READ_SIZE     512
+#define TEST_PIPE_READ_DELAY_US 100
+#define TEST_MSG_STALL_RESULT   "Logging returned %s the pipe was read (before expected). %d out of %d records were read back intact and in order."
+#define TEST_MSG_STALL_BEFORE   "before"
+#define TEST_MSG_STALL_AFTER    "after"
+#define TEST_STALL_LOGS         8   // Their writes do not fit in the pipe, but they fit in io_uring buffers.
+#define TEST_STALL_WAIT_US      1000000
+#define TEST_STALL_POLL_US      1000
+
+#define TEST_MSG_SHM_HEADER     "******** TESTING SHARED MEMORY RING ********"
+#define TEST_MSG_SHM            "Shared memory record %d.\nSecond line."
+#define TEST_MSG_SHM_READ       "Read back from ring: <%s>"
+#define TEST_MSG_SHM_RESULT     "%d out of %d lines were read back from the ring."
+#define TEST_SHM_NAME           "/svrty_log_test"
+#define TEST_SHM_SLOTS          16
+#define TEST_SHM_SLOT_SIZE      256
+#define TEST_SHM_LOGS           3
+#define TEST_MSG_SHM_STALL       "Record %d, published around a stalled writer."
+#define TEST_MSG_SHM_STALL_RESULT "Skipped records: %llu (1 expected). Read back %d record(s) (1 expected, record 3): <%s>"
+#define TEST_SHM_STALL_SLOTS      2
+
+#define TEST_MSG_PERCPU_HEADER  "******** TESTING PER-CPU STAGING ********"
+#define TEST_MSG_PERCPU         "Staged message %d.\nSecond line."
+#define TEST_PERCPU_LOGS        3
+#define TEST_MSG_LANES_HEADER   "******** TESTING PRIORITY LANES ********"
+#define TEST_MSG_LANES_DBG      "Low priority message %d."
+#define TEST_MSG_LANES_ERR      "High priority message, flushed before returning."
+#define TEST_MSG_LANES_RESULT   "Dropped low priority messages: %llu. Capture sink received %d lines (%d expected)."
+#define TEST_LANES_DBG_LOGS     200
+#define TEST_LANES_SEGMENT_SIZE 4096
+#define TEST_MSG_CONTEXT_HEADER "******** TESTING LOGGING CONTEXT ********"
+#define TEST_MSG_CONTEXT        "Message with context (depth %d)."
+#define TEST_CONTEXT_REQ_KEY    "req"
+#define TEST_CONTEXT_REQ_VALUE  "42"
+#define TEST_CONTEXT_USER_KEY   "tenant"
+#define TEST_CONTEXT_USER_VALUE "acme"
+#define TEST_CONTEXT_STEP_KEY   "step"
+#define TEST_CONTEXT_STEP_VALUE "commit"
+#define TEST_MSG_FILE_HEADER    "******** TESTING COMPRESSED FILE SINK ********"
+#define TEST_MSG_FILE           "File record %d.\nSecond line."
+#define TEST_MSG_FILE_READ      "Read back from file: <%.*s>"
+#define TEST_MSG_FILE_RESULT    "%d out of %d lines were read back from %u block(s)."
+#define TEST_MSG_FILE_SIDECAR   "Sidecar index holds %u entries (%d expected)."
+#define TEST_FILE_PATH          "/tmp/svrty_log_test.svl"
+#define TEST_FILE_SIDECAR_PATH  TEST_FILE_PATH SVRTY_FILE_SIDECAR_SUFFIX
+#define TEST_FILE_LOGS          3
+#define TEST_FILE_INDEX_RECORDS 2
+#define TEST_MSG_FILE_BURST         "Burst record %d."
+#define TEST_MSG_FILE_BURST_RESULT  "Blocking policy: %d out of %d records were read back, %llu dropped (0 expected)."
+#define TEST_MSG_FILE_BURST_DROP    "Dropping policy: %d out of %d WNG records were read back, %d INF ones were read back and %llu dropped (%d logged)."
+#define TEST_FILE_BURST_LOGS        20000
+#define TEST_FILE_BURST_WNG_EVERY   8
+#define TEST_FILE_BURST_BLOCK       4096
+#define TEST_MSG_THREAD_EXIT_HEADER "******** TESTING LOGS FROM THREAD KEY DESTRUCTORS ********"
+#define TEST_MSG_THREAD_EXIT        "Logged by thread %d."
+#define TEST_MSG_THREAD_EXIT_DTOR   "Logged by thread %d while exiting."
+#define TEST_MSG_THREAD_EXIT_RESULT "Key destructor log returned %d (> 0 expected)."
+#define TEST_MSG_CAPTURE_HEADER "******** TESTING CAPTURE SINK ********"
+#define TEST_MSG_CAPTURE        "Captured record.\nSecond line.\r\nThird line."
+#define TEST_MSG_CAPTURE_RESULT "Capture sink received %d lines (%d expected)."
+#define TEST_CAPTURE_LINES      3
+
 #define TEST_MSG_HEADER     "******** Test %d ********"
 #define TEST_MSG_RESULT     "Test %d %s.\n"
 #define TEST_MSG_FAILED     "failed"
@@ -71,6 +174,751 @@ void PrintMultiLineMessage(void)
     SVRTY_LOG_INF(TEST_MSG_MULTIPLE_LINES);
 }
 
+/// @brief Counts lines handed to the capture sink.
+static void CountCapturedLines(const uint8_t severity, const char* line, const size_t line_len, void* user_data)
+{
+    ++*(int*)user_data;
+}
+
+/// @brief Time a couple of sections, both by explicitly ending a span and by leaving a scope. Spans
+/// with a masked level must not be timed, and spans shorter than the threshold must not be logged.
+void PrintSpanMessages(void)
+{
+    SetSeverityLogMask(SVRTY_LOG_MASK_ALL);
+
+    SVRTY_LOG_INF(TEST_MSG_SPAN_HEADER);
+
+    volatile unsigned long dummy_sum = 0;
+
+    int masked_lines = 0;
+
+    SetSeverityLogCaptureSink(CountCapturedLines, &masked_lines);
+    SetSeverityLogMask(SVRTY_LOG_MASK_EIW);
+
+    SVRTY_LOG_SPAN_BEGIN(masked_span, SVRTY_LVL_DBG, TEST_MSG_SPAN_NAME);
+
+    // Level is enabled again by the time the span ends, so it is only silent if it was never timed.
+    SetSeverityLogMask(SVRTY_LOG_MASK_ALL);
+
+    int masked_result = SVRTY_LOG_SPAN_END(masked_span);
+
+    SetSeverityLogCaptureSink(NULL, NULL);
+    SetSeverityLogSpanThreshold(TEST_SPAN_THRESHOLD_NS);
+
+    SVRTY_LOG_SPAN_BEGIN(short_span, SVRTY_LVL_DBG, TEST_MSG_SPAN_NAME);
+    int short_result = SVRTY_LOG_SPAN_END(short_span);
+
+    SetSeverityLogSpanThreshold(0);
+
+    SVRTY_LOG_SPAN_BEGIN(test_span, SVRTY_LVL_DBG, TEST_MSG_SPAN_NAME);
+
+    for(unsigned long i = 0; i < TEST_SPAN_LOOPS; i++)
+        dummy_sum += i;
+
+    int logged_result = SVRTY_LOG_SPAN_END(test_span);
+
+    int captured_lines = 0;
+
+    SetSeverityLogCaptureSink(CountCapturedLines, &captured_lines);
+
+    {
+        SVRTY_LOG_SCOPE_TIMER(SVRTY_LVL_DBG, TEST_MSG_SCOPE_NAME);
+
+        for(unsigned long i = 0; i < TEST_SPAN_LOOPS; i++)
+            dummy_sum += i;
+    }
+
+    SetSeverityLogMask(SVRTY_LOG_MASK_EIW);
+
+    {
+        SVRTY_LOG_SCOPE_TIMER(SVRTY_LVL_DBG, TEST_MSG_SCOPE_NAME);
+    }
+
+    SetSeverityLogMask(SVRTY_LOG_MASK_ALL);
+    SetSeverityLogCaptureSink(NULL, NULL);
+
+    SVRTY_LOG_INF(TEST_MSG_SPAN_RESULT, masked_result, masked_lines, short_result, logged_result, captured_lines, SeverityLogSpanEnabled(0));
+}
+
+/// @brief Log many sampled messages. Only 1 out of TEST_SAMPLING_RATE (on average) should be printed.
+void PrintSampledMessages(void)
+{
+    SetSeverityLogMask(SVRTY_LOG_MASK_ALL);
+
+    SVRTY_LOG_INF(TEST_MSG_SAMPLING_HEADER);
+
+    SetSeverityLogSamplingRate(SVRTY_LVL_DBG, TEST_SAMPLING_RATE);
+
+    int printed_logs = 0;
+
+    for(int i = 0; i < TEST_SAMPLING_LOGS; i++)
+        if(SVRTY_LOG_DBG(TEST_MSG_SAMPLING, i) >= 0)
+            ++printed_logs;
+
+    SetSeverityLogSamplingRate(SVRTY_LVL_DBG, 0);
+
+    SVRTY_LOG_INF(TEST_MSG_SAMPLING_RESULT, printed_logs, TEST_SAMPLING_LOGS);
+}
+
+/// @brief Dump a table through a batch, committing whenever the caller-owned buffer gets full.
+void PrintBatchMessages(void)
+{
+    SetSeverityLogMask(SVRTY_LOG_MASK_ALL);
+
+    SVRTY_LOG_INF(TEST_MSG_BATCH_HEADER);
+
+    char batch_buffer[TEST_BATCH_BUFFER_SIZE];
+    SVRTY_LOG_BATCH batch;
+
+    if(SeverityLogBatchBegin(&batch, SVRTY_LVL_INF, batch_buffer, sizeof(batch_buffer)) < 0)
+        return;
+
+    int appended    = 0;
+    int printed     = 0;
+
+    for(int i = 0; i < TEST_BATCH_ROWS; i++)
+    {
+        int append_result = SeverityLogBatchAppend(&batch, TEST_MSG_BATCH_ROW, i, i * i);
+
+        if(append_result == SVRTY_LOG_BATCH_FULL)
+        {
+            printed += SeverityLogBatchCommit(&batch);
+            append_result = SeverityLogBatchAppend(&batch, TEST_MSG_BATCH_ROW, i, i * i);
+        }
+
+        if(append_result < 0)
+            break;
+
+        appended += append_result;
+    }
+
+    printed += SeverityLogBatchCommit(&batch);
+
+    SVRTY_LOG_INF(TEST_MSG_BATCH_RESULT, printed, appended);
+
+    // Sampling is decided per batch: rows are either all printed or none is.
+    int printed_batches = 0;
+    int partial_batches = 0;
+
+    SetSeverityLogSamplingRate(SVRTY_LVL_INF, TEST_SAMPLING_RATE);
+
+    for(int i = 0; i < TEST_SAMPLING_LOGS; i++)
+    {
+        int appended_rows = 0;
+
+        SeverityLogBatchBegin(&batch, SVRTY_LVL_INF, batch_buffer, sizeof(batch_buffer));
+
+        for(int j = 0; j < TEST_BATCH_SAMPLED_ROWS; j++)
+            appended_rows += (SeverityLogBatchAppend(&batch, TEST_MSG_BATCH_ROW, i, j) >= 0 ? 1 : 0);
+
+        printed_batches += (SeverityLogBatchCommit(&batch) > 0 ? 1 : 0);
+        partial_batches += (appended_rows > 0 && appended_rows < TEST_BATCH_SAMPLED_ROWS ? 1 : 0);
+    }
+
+    SetSeverityLogSamplingRate(SVRTY_LVL_INF, 0);
+
+    SVRTY_LOG_INF(TEST_MSG_BATCH_SAMPLED, printed_batches, TEST_SAMPLING_LOGS, partial_batches);
+}
+
+/// @brief Print a multi-line log through every output backend, then go back to the default one.
+void PrintBackendMessages(void)
+{
+    SetSeverityLogMask(SVRTY_LOG_MASK_ALL);
+
+    SVRTY_LOG_INF(TEST_MSG_BACKEND_HEADER);
+
+    int backends[] = {  SVRTY_LOG_BACKEND_WRITEV    ,
+                        SVRTY_LOG_BACKEND_IO_URING  };
+
+    for(int i = 0; i < (sizeof(backends) / sizeof(backends[0])); i++)
+        SVRTY_LOG_INF(TEST_MSG_BACKEND, SetSeverityLogOutputBackend(backends[i]));
+
+    SeverityLogFlush();
+    SetSeverityLogOutputBackend(SVRTY_LOG_BACKEND_STDIO);
+}
+
+typedef struct
+{
+    int     fd;
+    char*   output;
+    size_t  output_len;
+} TEST_PIPE_READER;
+
+/// @brief Reads a pipe slowly until every write end is closed, so that it is full most of the time.
+static void* ReadPipeSlowly(void* arg)
+{
+    TEST_PIPE_READER* reader = (TEST_PIPE_READER*)arg;
+
+    while(reader->output_len < TEST_PIPE_OUTPUT_SIZE)
+    {
+        size_t to_read = TEST_PIPE_OUTPUT_SIZE - reader->output_len;
+        ssize_t read_len = read(reader->fd, reader->output + reader->output_len, (to_read < TEST_PIPE_READ_SIZE ? to_read : TEST_PIPE_READ_SIZE));
+
+        if(read_len <= 0)
+            break;
+
+        reader->output_len += read_len;
+        usleep(TEST_PIPE_READ_DELAY_US);
+    }
+
+    return NULL;
+}
+
+/// @brief Counts records read back whole and in order, stopping at the first one which is not.
+static int CountPipeRecords(char* output, const size_t output_len)
+{
+    int records = 0;
+    const char* end = output + output_len;
+
+    output[output_len] = '\0';
+
+    const char* ptr = output;
+
+    while((ptr = strstr(ptr, TEST_MSG_PIPE_RECORD)) != NULL)
+    {
+        char* padding;
+        ptr += strlen(TEST_MSG_PIPE_RECORD);
+
+        if(strtol(ptr, &padding, 10) != records || *padding++ != ' ')
+            break;
+
+        size_t padding_len = 0;
+
+        while(padding + padding_len < end && padding[padding_len] == TEST_PIPE_PADDING_CHAR)
+            ++padding_len;
+
+        if(padding_len != TEST_PIPE_PADDING_LEN)
+            break;
+
+        ++records;
+    }
+
+    return records;
+}
+
+/// @brief Log to a pipe which is read slowly, so that writes come out short, then check what was read back.
+void PrintShortWriteMessages(void)
+{
+    SetSeverityLogMask(SVRTY_LOG_MASK_ALL);
+
+    SVRTY_LOG_INF(TEST_MSG_PIPE_HEADER);
+
+    static char padding[TEST_PIPE_PADDING_LEN + 1];
+    memset(padding, TEST_PIPE_PADDING_CHAR, TEST_PIPE_PADDING_LEN);
+
+    int backends[] = {  SVRTY_LOG_BACKEND_WRITEV    ,
+                        SVRTY_LOG_BACKEND_IO_URING  };
+
+    SetSeverityLogBufferSize(TEST_PIPE_BUFFER_SIZE);
+
+    for(int i = 0; i < (sizeof(backends) / sizeof(backends[0])); i++)
+    {
+        int pipe_fds[2];
+        TEST_PIPE_READER reader = {0};
+        pthread_t reader_thread;
+
+        if(pipe(pipe_fds) < 0)
+            return;
+
+        reader.fd       = pipe_fds[0];
+        reader.output   = (char*)malloc(TEST_PIPE_OUTPUT_SIZE + 1);
+
+        fflush(stdout);
+
+        int saved_stdout = dup(STDOUT_FILENO);
+
+        dup2(pipe_fds[1], STDOUT_FILENO);
+        close(pipe_fds[1]);
+
+        pthread_create(&reader_thread, NULL, ReadPipeSlowly, &reader);
+
+        int backend = SetSeverityLogOutputBackend(backends[i]);
+
+        for(int j = 0; j < TEST_PIPE_LOGS; j++)
+            SVRTY_LOG_INF(TEST_MSG_PIPE, j, padding);
+
+        SeverityLogFlush();
+        SetSeverityLogOutputBackend(SVRTY_LOG_BACKEND_STDIO);
+
+        // Reader gets EOF once the last write end (stdout) is gone.
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+
+        pthread_join(reader_thread, NULL);
+        close(pipe_fds[0]);
+
+        SVRTY_LOG_INF(TEST_MSG_PIPE_RESULT, CountPipeRecords(reader.output, reader.output_len), TEST_PIPE_LOGS, backend);
+
+        free(reader.output);
+    }
+
+    SetSeverityLogBufferSize(TEST_LOG_BUFFER_SIZE);
+}
+
+static int stalled_logs_done;
+
+static void* LogToStalledPipe(void* padding)
+{
+    for(int i = 0; i < TEST_STALL_LOGS; i++)
+        SVRTY_LOG_INF(TEST_MSG_PIPE, i, (const char*)padding);
+
+    __atomic_store_n(&stalled_logs_done, 1, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+/// @brief Log through io_uring to a pipe nobody reads yet. Logging must not wait for the pipe to be
+/// read (as long as io_uring buffers are available), and records must come out in order once it is.
+void PrintStalledPipeMessages(void)
+{
+    SetSeverityLogMask(SVRTY_LOG_MASK_ALL);
+
+    static char padding[TEST_PIPE_PADDING_LEN + 1];
+    memset(padding, TEST_PIPE_PADDING_CHAR, TEST_PIPE_PADDING_LEN);
+
+    SetSeverityLogBufferSize(TEST_PIPE_BUFFER_SIZE);
+
+    int pipe_fds[2];
+    TEST_PIPE_READER reader = {0};
+    pthread_t logging_thread, reader_thread;
+
+    if(pipe(pipe_fds) < 0)
+        return;
+
+    reader.fd       = pipe_fds[0];
+    reader.output   = (char*)malloc(TEST_PIPE_OUTPUT_SIZE + 1);
+
+    fflush(stdout);
+
+    int saved_stdout = dup(STDOUT_FILENO);
+
+    dup2(pipe_fds[1], STDOUT_FILENO);
+    close(pipe_fds[1]);
+
+    SetSeverityLogOutputBackend(SVRTY_LOG_BACKEND_IO_URING);
+
+    __atomic_store_n(&stalled_logs_done, 0, __ATOMIC_RELAXED);
+
+    pthread_create(&logging_thread, NULL, LogToStalledPipe, padding);
+
+    for(int waited_us = 0; waited_us < TEST_STALL_WAIT_US && !__atomic_load_n(&stalled_logs_done, __ATOMIC_ACQUIRE); waited_us += TEST_STALL_POLL_US)
+        usleep(TEST_STALL_POLL_US);
+
+    bool returned_before_read = __atomic_load_n(&stalled_logs_done, __ATOMIC_ACQUIRE);
+
+    pthread_create(&reader_thread, NULL, ReadPipeSlowly, &reader);
+    pthread_join(logging_thread, NULL);
+
+    SeverityLogFlush();
+    SetSeverityLogOutputBackend(SVRTY_LOG_BACKEND_STDIO);
+
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+
+    pthread_join(reader_thread, NULL);
+    close(pipe_fds[0]);
+
+    SVRTY_LOG_INF(  TEST_MSG_STALL_RESULT                                               ,
+                    (returned_before_read ? TEST_MSG_STALL_BEFORE : TEST_MSG_STALL_AFTER),
+                    CountPipeRecords(reader.output, reader.output_len)                  ,
+                    TEST_STALL_LOGS                                                     );
+
+    free(reader.output);
+
+    SetSeverityLogBufferSize(TEST_LOG_BUFFER_SIZE);
+}
+
+/// @brief Publish logs into a shared memory ring (not to stdout), then read them back as a collector would.
+void PrintShmMessages(void)
+{
+    SetSeverityLogMask(SVRTY_LOG_MASK_ALL);
+
+    SVRTY_LOG_INF(TEST_MSG_SHM_HEADER);
+
+    // Leftovers from previous runs are not wanted.
+    shm_unlink(TEST_SHM_NAME);
+
+    if(SetSeverityLogShmSink(TEST_SHM_NAME, TEST_SHM_SLOTS, TEST_SHM_SLOT_SIZE) < 0)
+        return;
+
+    SVRTY_SHM_READER reader;
+
+    if(SeverityLogShmReaderOpen(&reader, TEST_SHM_NAME) < 0)
+    {
+        SetSeverityLogShmSink(NULL, 0, 0);
+        shm_unlink(TEST_SHM_NAME);
+        return;
+    }
+
+    SetSeverityLogStdoutStatus(false);
+
+    for(int i = 0; i < TEST_SHM_LOGS; i++)
+        SVRTY_LOG_INF(TEST_MSG_SHM, i);
+
+    SetSeverityLogStdoutStatus(true);
+    SetSeverityLogShmSink(NULL, 0, 0);
+
+    const SVRTY_SHM_RECORD* record;
+    int read_records = 0;
+
+    while(SeverityLogShmReaderNext(&reader, &record, 0) == 0)
+    {
+        SVRTY_LOG_INF(TEST_MSG_SHM_READ, record->payload);
+
+        if(SeverityLogShmReaderRelease(&reader) == 0)
+            ++read_records;
+    }
+
+    SVRTY_LOG_INF(TEST_MSG_SHM_RESULT, read_records, TEST_SHM_LOGS * 2);
+
+    SeverityLogShmReaderClose(&reader);
+    shm_unlink(TEST_SHM_NAME);
+}
+
+/// @brief Simulate a writer that stalls while writing into a slot: a writer a lap ahead must skip
+/// its record rather than writing into the same slot, and the reader must not wait for it.
+void PrintShmStalledWriterMessages(void)
+{
+    SetSeverityLogMask(SVRTY_LOG_MASK_ALL);
+
+    shm_unlink(TEST_SHM_NAME);
+
+    if(SetSeverityLogShmSink(TEST_SHM_NAME, TEST_SHM_STALL_SLOTS, TEST_SHM_SLOT_SIZE) < 0)
+        return;
+
+    SVRTY_SHM_READER reader;
+
+    if(SeverityLogShmReaderOpen(&reader, TEST_SHM_NAME) < 0)
+    {
+        SetSeverityLogShmSink(NULL, 0, 0);
+        shm_unlink(TEST_SHM_NAME);
+        return;
+    }
+
+    SetSeverityLogStdoutStatus(false);
+
+    // Record 0 is claimed by a writer that does not get to finish it for a while.
+    SVRTY_SHM_RECORD* stalled_slot = (SVRTY_SHM_RECORD*)((char*)reader.header + sizeof(SVRTY_SHM_HEADER));
+    uint64_t stalled_seq = __atomic_fetch_add(&reader.header->write_seq, 1, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&stalled_slot->seq, SVRTY_SHM_SEQ_WRITING(stalled_seq), __ATOMIC_RELEASE);
+
+    SVRTY_LOG_INF(TEST_MSG_SHM_STALL, 1);
+    SVRTY_LOG_INF(TEST_MSG_SHM_STALL, 2);   // Skipped: it goes into record 0's slot.
+
+    __atomic_store_n(&stalled_slot->seq, SVRTY_SHM_SEQ_DONE(stalled_seq), __ATOMIC_RELEASE);
+
+    SVRTY_LOG_INF(TEST_MSG_SHM_STALL, 3);
+
+    SetSeverityLogStdoutStatus(true);
+    SetSeverityLogShmSink(NULL, 0, 0);
+
+    const SVRTY_SHM_RECORD* record;
+    char last_payload[TEST_SHM_SLOT_SIZE] = {0};
+    int read_records = 0;
+
+    while(SeverityLogShmReaderNext(&reader, &record, 0) == 0)
+    {
+        snprintf(last_payload, sizeof(last_payload), "%s", record->payload);
+
+        if(SeverityLogShmReaderRelease(&reader) == 0)
+            ++read_records;
+    }
+
+    SVRTY_LOG_INF(TEST_MSG_SHM_STALL_RESULT, (unsigned long long)reader.header->skipped, read_records, last_payload);
+
+    SeverityLogShmReaderClose(&reader);
+    shm_unlink(TEST_SHM_NAME);
+}
+
+/// @brief Stage logs into per-CPU buffers, then disable staging (which prints whatever is still staged).
+void PrintPerCpuMessages(void)
+{
+    SetSeverityLogMask(SVRTY_LOG_MASK_ALL);
+
+    SVRTY_LOG_INF(TEST_MSG_PERCPU_HEADER);
+
+    if(SetSeverityLogPerCpuStaging(true, 0, NULL, 0) < 0)
+        return;
+
+    for(int i = 0; i < TEST_PERCPU_LOGS; i++)
+        SVRTY_LOG_INF(TEST_MSG_PERCPU, i);
+
+    SetSeverityLogPerCpuStaging(false, 0, NULL, 0);
+}
+
+/// @brief Flood the low priority lane (dropping what does not fit), then log an ERR that must not wait for it.
+void PrintPriorityLaneMessages(void)
+{
+    SetSeverityLogMask(SVRTY_LOG_MASK_ALL);
+
+    SVRTY_LOG_INF(TEST_MSG_LANES_HEADER);
+
+    if(SetSeverityLogPerCpuStaging(true, TEST_LANES_SEGMENT_SIZE, NULL, 0) < 0)
+        return;
+
+    SetSeverityLogOverflowPolicy(SVRTY_LOG_OVERFLOW_DROP);
+    SetSeverityLogErrSyncFlush(true);
+
+    // Logs dropped from stdout must still reach the capture sink.
+    int captured_lines = 0;
+
+    SetSeverityLogCaptureSink(CountCapturedLines, &captured_lines);
+
+    for(int i = 0; i < TEST_LANES_DBG_LOGS; i++)
+        SVRTY_LOG_DBG(TEST_MSG_LANES_DBG, i);
+
+    SVRTY_LOG_ERR(TEST_MSG_LANES_ERR);
+
+    SetSeverityLogPerCpuStaging(false, 0, NULL, 0);
+    SetSeverityLogCaptureSink(NULL, NULL);
+
+    SetSeverityLogOverflowPolicy(SVRTY_LOG_OVERFLOW_BLOCK);
+    SetSeverityLogErrSyncFlush(false);
+
+    SVRTY_LOG_INF(TEST_MSG_LANES_RESULT, (unsigned long long)SeverityLogGetDroppedCount(), captured_lines, TEST_LANES_DBG_LOGS + 1);
+}
+
+/// @brief Nest logging context entries (by hand and scoped), logging at each depth.
+void PrintContextMessages(void)
+{
+    SetSeverityLogMask(SVRTY_LOG_MASK_ALL);
+
+    SVRTY_LOG_INF(TEST_MSG_CONTEXT_HEADER);
+
+    SeverityLogContextPush(TEST_CONTEXT_REQ_KEY, TEST_CONTEXT_REQ_VALUE);
+    SVRTY_LOG_INF(TEST_MSG_CONTEXT, 1);
+
+    SeverityLogContextPush(TEST_CONTEXT_USER_KEY, TEST_CONTEXT_USER_VALUE);
+    SVRTY_LOG_WNG(TEST_MSG_CONTEXT, 2);
+
+    {
+        SVRTY_LOG_CONTEXT_SCOPE(TEST_CONTEXT_STEP_KEY, TEST_CONTEXT_STEP_VALUE);
+        SVRTY_LOG_DBG(TEST_MSG_CONTEXT, 3);
+    }
+
+    SVRTY_LOG_WNG(TEST_MSG_CONTEXT, 2);
+
+    SeverityLogContextPop();
+    SeverityLogContextPop();
+
+    SVRTY_LOG_INF(TEST_MSG_CONTEXT, 0);
+}
+
+/// @brief Write logs into a compressed file only (not to stdout), then read them back.
+void PrintFileMessages(void)
+{
+    SetSeverityLogMask(SVRTY_LOG_MASK_ALL);
+
+    SVRTY_LOG_INF(TEST_MSG_FILE_HEADER);
+
+    SetSeverityLogFileSidecarIndex(TEST_FILE_INDEX_RECORDS, 0);
+
+    if(SetSeverityLogFileSink(TEST_FILE_PATH, SVRTY_LOG_FILE_COMPRESSION_LZ, 0) < 0)
+        return;
+
+    SetSeverityLogStdoutStatus(false);
+
+    for(int i = 0; i < TEST_FILE_LOGS; i++)
+        SVRTY_LOG_INF(TEST_MSG_FILE, i);
+
+    SetSeverityLogStdoutStatus(true);
+    SetSeverityLogFileSink(NULL, 0, 0);
+    SetSeverityLogFileSidecarIndex(0, 0);
+
+    SVRTY_FILE_READER reader;
+
+    if(SeverityLogFileReaderOpen(&reader, TEST_FILE_PATH) < 0)
+    {
+        unlink(TEST_FILE_PATH);
+        unlink(TEST_FILE_SIDECAR_PATH);
+        return;
+    }
+
+    int read_records = 0;
+
+    for(uint32_t block = 0; block < reader.block_amount; block++)
+    {
+        const uint8_t* records;
+        size_t records_length;
+
+        if(SeverityLogFileReaderBlock(&reader, block, &records, &records_length) < 0)
+            continue;
+
+        for(size_t offset = 0; offset < records_length; read_records++)
+        {
+            const SVRTY_FILE_RECORD* record = (const SVRTY_FILE_RECORD*)(records + offset);
+
+            SVRTY_LOG_INF(TEST_MSG_FILE_READ, (int)record->length, record->line);
+
+            offset += SVRTY_FILE_RECORD_SIZE(record->length);
+        }
+    }
+
+    SVRTY_LOG_INF(TEST_MSG_FILE_RESULT, read_records, TEST_FILE_LOGS * 2, reader.block_amount);
+
+    SeverityLogFileReaderClose(&reader);
+    unlink(TEST_FILE_PATH);
+
+    SVRTY_FILE_SIDECAR sidecar;
+
+    if(SeverityLogFileSidecarOpen(&sidecar, TEST_FILE_PATH) == SVRTY_FILE_SUCCESS)
+    {
+        SVRTY_LOG_INF(TEST_MSG_FILE_SIDECAR, sidecar.entry_amount, TEST_FILE_LOGS * 2 / TEST_FILE_INDEX_RECORDS);
+        SeverityLogFileSidecarClose(&sidecar);
+    }
+
+    unlink(TEST_FILE_SIDECAR_PATH);
+}
+
+/// @brief Counts records of a given severity (0: any) in a log file, or returns < 0 if it cannot be read.
+static int CountFileRecords(const char* path, const uint8_t severity)
+{
+    SVRTY_FILE_READER reader;
+
+    if(SeverityLogFileReaderOpen(&reader, path) < 0)
+        return -1;
+
+    int read_records = 0;
+
+    for(uint32_t block = 0; block < reader.block_amount; block++)
+    {
+        const uint8_t* records;
+        size_t records_length;
+
+        if(SeverityLogFileReaderBlock(&reader, block, &records, &records_length) < 0)
+            continue;
+
+        for(size_t offset = 0; offset < records_length;)
+        {
+            const SVRTY_FILE_RECORD* record = (const SVRTY_FILE_RECORD*)(records + offset);
+
+            if(severity == 0 || record->severity == severity)
+                read_records++;
+
+            offset += SVRTY_FILE_RECORD_SIZE(record->length);
+        }
+    }
+
+    SeverityLogFileReaderClose(&reader);
+
+    return read_records;
+}
+
+/// @brief Logs a burst of records (every few ones a WNG) into small file blocks, faster than they may be written.
+/// @return Number of records dropped from the file, or UINT64_MAX if it could not be opened.
+static uint64_t LogFileBurst(void)
+{
+    if(SetSeverityLogFileSink(TEST_FILE_PATH, SVRTY_LOG_FILE_COMPRESSION_LZ, TEST_FILE_BURST_BLOCK) < 0)
+        return UINT64_MAX;
+
+    SetSeverityLogStdoutStatus(false);
+
+    for(int i = 0; i < TEST_FILE_BURST_LOGS; i++)
+    {
+        if(i % TEST_FILE_BURST_WNG_EVERY == 0)
+            SVRTY_LOG_WNG(TEST_MSG_FILE_BURST, i);
+        else
+            SVRTY_LOG_INF(TEST_MSG_FILE_BURST, i);
+    }
+
+    SetSeverityLogStdoutStatus(true);
+
+    // Read before closing, as the count is reset when a file is opened.
+    uint64_t dropped = SeverityLogGetFileDroppedCount();
+
+    SetSeverityLogFileSink(NULL, 0, 0);
+
+    return dropped;
+}
+
+/// @brief Fill small file blocks faster than they may be written: loggers never wait for the writer. Every record
+/// ends up in the file by default, while only INF ones may be dropped (and counted) under SVRTY_LOG_OVERFLOW_DROP.
+void PrintFileBurstMessages(void)
+{
+    SetSeverityLogMask(SVRTY_LOG_MASK_ALL);
+
+    uint64_t dropped = LogFileBurst();
+
+    if(dropped == UINT64_MAX)
+        return;
+
+    SVRTY_LOG_INF(TEST_MSG_FILE_BURST_RESULT, CountFileRecords(TEST_FILE_PATH, 0), TEST_FILE_BURST_LOGS, (unsigned long long)dropped);
+
+    SetSeverityLogOverflowPolicy(SVRTY_LOG_OVERFLOW_DROP);
+    dropped = LogFileBurst();
+    SetSeverityLogOverflowPolicy(SVRTY_LOG_OVERFLOW_BLOCK);
+
+    if(dropped == UINT64_MAX)
+        return;
+
+    int wng_logs = (TEST_FILE_BURST_LOGS + TEST_FILE_BURST_WNG_EVERY - 1) / TEST_FILE_BURST_WNG_EVERY;
+
+    SVRTY_LOG_INF(  TEST_MSG_FILE_BURST_DROP, CountFileRecords(TEST_FILE_PATH, SVRTY_LVL_WNG), wng_logs,
+                    CountFileRecords(TEST_FILE_PATH, SVRTY_LVL_INF), (unsigned long long)dropped, TEST_FILE_BURST_LOGS - wng_logs);
+
+    unlink(TEST_FILE_PATH);
+}
+
+static pthread_key_t thread_exit_key;
+static int thread_exit_result;
+
+/// @brief Logs once the library's own key destructor may have freed the thread's log buffer.
+static void LogOnThreadExit(void* thread_number)
+{
+    thread_exit_result = SVRTY_LOG_INF(TEST_MSG_THREAD_EXIT_DTOR, *(int*)thread_number);
+}
+
+/// @brief Logs, so that the thread's log buffer exists, then exits with a key to be destroyed.
+static void* LogAndExit(void* thread_number)
+{
+    SVRTY_LOG_INF(TEST_MSG_THREAD_EXIT, *(int*)thread_number);
+
+    pthread_setspecific(thread_exit_key, thread_number);
+
+    return NULL;
+}
+
+/// @brief Log from a pthread key destructor, which glibc runs after the library's own one.
+void PrintThreadExitMessages(void)
+{
+    SetSeverityLogMask(SVRTY_LOG_MASK_ALL);
+
+    SVRTY_LOG_INF(TEST_MSG_THREAD_EXIT_HEADER);
+
+    pthread_key_create(&thread_exit_key, LogOnThreadExit);
+
+    int thread_number = 1;
+    pthread_t thread;
+
+    pthread_create(&thread, NULL, LogAndExit, &thread_number);
+    pthread_join(thread, NULL);
+
+    pthread_key_delete(thread_exit_key);
+
+    SVRTY_LOG_INF(TEST_MSG_THREAD_EXIT_RESULT, thread_exit_result);
+}
+
+/// @brief Hand a multi-line log to a capture sink only (not to stdout), counting its lines.
+void PrintCaptureMessages(void)
+{
+    SetSeverityLogMask(SVRTY_LOG_MASK_ALL);
+
+    SVRTY_LOG_INF(TEST_MSG_CAPTURE_HEADER);
+
+    int captured_lines = 0;
+
+    SetSeverityLogCaptureSink(CountCapturedLines, &captured_lines);
+    SetSeverityLogStdoutStatus(false);
+
+    SVRTY_LOG_WNG(TEST_MSG_CAPTURE);
+
+    SetSeverityLogStdoutStatus(true);
+    SetSeverityLogCaptureSink(NULL, NULL);
+
+    SVRTY_LOG_INF(TEST_MSG_CAPTURE_RESULT, captured_lines, TEST_CAPTURE_LINES);
+}
+
 int main()
 {
     int severity_log_masks[] = {SVRTY_LOG_MASK_OFF,
@@ -116,6 +964,24 @@ int main()
 
     PrintMultiLineMessage();
 
+    PrintSpanMessages();
+
+    PrintSampledMessages();
+
+    PrintBatchMessages();
+    PrintBackendMessages();
+    PrintShortWriteMessages();
+    PrintStalledPipeMessages();
+    PrintShmMessages();
+    PrintShmStalledWriterMessages();
+    PrintPerCpuMessages();
+    PrintPriorityLaneMessages();
+    PrintContextMessages();
+    PrintFileMessages();
+    PrintFileBurstMessages();
+    PrintCaptureMessages();
+    PrintThreadExitMessages();
+
     return 0;
 }
 
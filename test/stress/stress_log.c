@@ -0,0 +1,682 @@
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include "SeverityLog_api.h"
+
+/************************************/
+
+/***********************************/
+/******** Define statements ********/
+/***********************************/
+
+#define STRESS_LOG_BUFFER_SIZE      2048
+#define STRESS_LOG_INIT_MASK        0x7A    // ERR, INF and WNG, time and TID. No exe file name (backtraces would dominate), no syslog.
+#define STRESS_DEFAULT_THREADS      16
+#define STRESS_DEFAULT_RECORDS      20000
+#define STRESS_MAX_THREADS          256
+#define STRESS_MAX_LINES            4
+#define STRESS_MAX_FILLER           160
+#define STRESS_MAX_PAYLOAD          (STRESS_MAX_LINES * (STRESS_MAX_FILLER + 64))
+#define STRESS_MIN_BUFFER_SIZE      1024    // Resizes never go below the longest payload, so none of them is truncated.
+#define STRESS_MAX_BUFFER_SIZE      8192
+#define STRESS_CHAOS_PERIOD_US      100
+#define STRESS_SIGNAL_PERIOD_US     50
+#define STRESS_SIGNAL               SIGUSR1
+#define STRESS_CLEANUP_DELAY_US     20000
+#define STRESS_CLEANUP_TIMEOUT_S    10
+#define STRESS_NULL_DEVICE          "/dev/null"
+#define STRESS_READ_SIZE            65536
+#define STRESS_MAX_OUTPUT_LINE      1024    // Longest line printed to stdout (prefix included).
+#define STRESS_SYNC_PERIOD_US       1000
+#define STRESS_CONTEXT_KEY          "rec"
+#define STRESS_CONTEXT_SIZE         16
+
+#define STRESS_LINE_MARKER          "@T"
+#define STRESS_LINE_HEADER          "@T%u S%u L%u/%u N%u #"
+#define STRESS_LINE_HEADER_FIELDS   5
+#define STRESS_LINE_END             '$'
+#define STRESS_LINE_SEPARATOR       '\n'
+#define STRESS_OUTPUT_CR            '\r'
+#define STRESS_COLOR_RESET          "\033[0m"
+#define STRESS_SYNC_FORMAT          "%%SYNC %" PRIu64 "\n"
+#define STRESS_SYNC_MARKER          "%SYNC "
+
+#define STRESS_LANE_HIGH            0       // ERR and WNG records (see SetSeverityLogPerCpuStaging).
+#define STRESS_LANE_LOW             1       // INF and DBG records.
+#define STRESS_LANE_AMOUNT          2
+
+#define STRESS_RESULT_FORMAT        "%-28s %4d threads %10.0f logs/s %10.0f lines/s\n"
+#define STRESS_VERDICT_FORMAT       "    %s\n"
+#define STRESS_DETAIL_FORMAT        "    %-13s %" PRIu64 " records, %" PRIu64 " lines, %" PRIu64 " corrupted, %" PRIu64 " interleaved, "  \
+                                    "%" PRIu64 " out of order, %" PRIu64 " missing, %" PRIu64 " failed calls, %" PRIu64 " signals\n"
+#define STRESS_CLEANUP_FORMAT       "%-28s %4d threads %s (child %s %d)\n"
+#define STRESS_USAGE                "Usage: %s [threads [records_per_thread]]\n"
+#define STRESS_PASSED               "PASSED"
+#define STRESS_FAILED               "FAILED"
+
+#define STRESS_NS_PER_SEC           1000000000.0
+
+/***********************************/
+
+/**********************************/
+/******** Type definitions ********/
+/**********************************/
+
+/// @brief What is known about each logging thread's records, as seen by the capture sink or on stdout.
+typedef struct
+{
+    uint32_t    next_seq                        ;   // Lowest sequence number the next record may have.
+    uint32_t    next_lane_seq[STRESS_LANE_AMOUNT];  // Same, within the record's priority lane.
+    uint64_t    records                         ;   // Complete records received.
+} STRESS_THREAD_STATE;
+
+/// @brief Checked output state. The capture sink one is only accessed from the capture callback (under the
+/// output mutex), the stdout one from the output reader thread, and both once the phase is synced.
+typedef struct
+{
+    STRESS_THREAD_STATE threads[STRESS_MAX_THREADS] ;
+    bool                lane_order                  ;   // Only order within each priority lane is kept (staged output).
+    bool                record_open                 ;   // A multi-line record is halfway received.
+    uint32_t            open_thread                 ;
+    uint32_t            open_seq                    ;
+    uint32_t            open_line                   ;   // Next line expected from the open record.
+    uint32_t            open_lines                  ;
+    uint64_t            records                     ;
+    uint64_t            lines                       ;
+    uint64_t            corrupted                   ;   // Lines whose payload does not match what was logged.
+    uint64_t            interleaved                 ;   // Lines found in between another record's lines.
+    uint64_t            out_of_order                ;   // Records received after a newer one from the same thread.
+} STRESS_CAPTURE;
+
+/// @brief Stress phase settings.
+typedef struct
+{
+    const char* name            ;
+    bool        staging         ;   // Per-CPU staging enabled from the beginning.
+    bool        chaos           ;   // Settings are changed (and signals sent) while logging.
+} STRESS_PHASE;
+
+/**********************************/
+
+/***********************************/
+/******** Private variables ********/
+/***********************************/
+
+static STRESS_CAPTURE   capture                             = {0}   ;
+static STRESS_CAPTURE   output                              = {0}   ;
+static int              output_pipe[2]                      = {-1, -1};
+static uint64_t         output_synced                       = 0     ;
+static uint64_t         output_sync_requested               = 0     ;
+static pthread_t        workers[STRESS_MAX_THREADS]                 ;
+static int              thread_amount                       = STRESS_DEFAULT_THREADS;
+static uint32_t         records_per_thread                  = STRESS_DEFAULT_RECORDS;
+static uint64_t         failed_calls                        = 0     ;
+static uint64_t         signals_received                    = 0     ;
+static int              workers_done                        = 0     ;
+static bool             chaos_stop                          = false ;
+
+/***********************************/
+
+/*************************************/
+/******* Function definitions ********/
+/*************************************/
+
+/// @brief Filler byte of a given line. Depends on every field in the line header, so that misplaced bytes are noticed.
+static char StressFiller(const uint32_t thread, const uint32_t seq, const uint32_t line, const uint32_t idx)
+{
+    return (char)('a' + ((thread * 31 + seq * 7 + line * 3 + idx) % 26));
+}
+
+/// @brief Severity level each record is logged with (ERR, WNG and INF in turns).
+static uint8_t StressSeverity(const uint32_t seq)
+{
+    static const uint8_t severities[] = {SVRTY_LVL_INF, SVRTY_LVL_WNG, SVRTY_LVL_INF, SVRTY_LVL_ERR};
+
+    return severities[seq % (sizeof(severities) / sizeof(severities[0]))];
+}
+
+/// @brief Per-thread xorshift32 generator.
+static uint32_t StressRand(uint32_t* state)
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    *state = x;
+
+    return x;
+}
+
+/// @brief Builds a record made of several lines, each of them holding its own header and filler.
+static size_t StressBuildRecord(char* payload, const uint32_t thread, const uint32_t seq, uint32_t* rng_state)
+{
+    uint32_t line_amount    = 1 + StressRand(rng_state) % STRESS_MAX_LINES;
+    size_t length           = 0;
+
+    for(uint32_t line = 0; line < line_amount; line++)
+    {
+        uint32_t filler_len = StressRand(rng_state) % (STRESS_MAX_FILLER + 1);
+
+        if(line > 0)
+            payload[length++] = STRESS_LINE_SEPARATOR;
+
+        length += (size_t)sprintf(payload + length, STRESS_LINE_HEADER, thread, seq, line, line_amount, filler_len);
+
+        for(uint32_t i = 0; i < filler_len; i++)
+            payload[length++] = StressFiller(thread, seq, line, i);
+
+        payload[length++] = STRESS_LINE_END;
+    }
+
+    payload[length] = '\0';
+
+    return length;
+}
+
+/// @brief Priority lane a record is staged into, depending on its severity level.
+static int StressLane(const uint8_t severity)
+{
+    return (severity == SVRTY_LVL_ERR || severity == SVRTY_LVL_WNG ? STRESS_LANE_HIGH : STRESS_LANE_LOW);
+}
+
+/// @brief Checks a line (as handed to the capture sink or printed to stdout) and keeps track of record boundaries.
+static void StressCheckLine(STRESS_CAPTURE* state, const uint8_t severity, const char* line, const size_t line_len)
+{
+    const char* payload = strstr(line, STRESS_LINE_MARKER);
+
+    // Lines logged by anyone else (i.e. the library itself) are not checked.
+    if(payload == NULL)
+        return;
+
+    state->lines++;
+
+    uint32_t thread, seq, line_idx, line_amount, filler_len;
+    int header_len = 0;
+
+    bool intact = ( sscanf(payload, STRESS_LINE_HEADER "%n", &thread, &seq, &line_idx, &line_amount, &filler_len, &header_len) == STRESS_LINE_HEADER_FIELDS  &&
+                    header_len > 0                                                                                                                          &&
+                    thread < (uint32_t)thread_amount                                                                                                        &&
+                    line_idx < line_amount                                                                                                                  &&
+                    line_amount <= STRESS_MAX_LINES                                                                                                         &&
+                    filler_len <= STRESS_MAX_FILLER                                                                                                         &&
+                    (size_t)(payload - line) + header_len + filler_len + 1 == line_len                                                                      &&
+                    payload[header_len + filler_len] == STRESS_LINE_END                                                                                     &&
+                    severity == StressSeverity(seq)                                                                                                         );
+
+    for(uint32_t i = 0; intact && i < filler_len; i++)
+        intact = (payload[header_len + i] == StressFiller(thread, seq, line_idx, i));
+
+    if(!intact)
+    {
+        state->corrupted++;
+        state->record_open = false;
+        return;
+    }
+
+    bool continues_record = (state->record_open && thread == state->open_thread && seq == state->open_seq && line_idx == state->open_line);
+
+    if(!continues_record)
+    {
+        // Either the open record was cut short, or this line does not start a record.
+        if(state->record_open || line_idx != 0)
+            state->interleaved++;
+
+        // Staged ERR/WNG records are drained first, so they may overtake INF records logged before them.
+        int lane = StressLane(severity);
+        uint32_t next_seq = (state->lane_order ? state->threads[thread].next_lane_seq[lane] : state->threads[thread].next_seq);
+
+        if(seq < next_seq)
+            state->out_of_order++;
+
+        state->threads[thread].next_seq             = seq + 1;
+        state->threads[thread].next_lane_seq[lane]  = seq + 1;
+
+        state->record_open  = true;
+        state->open_thread  = thread;
+        state->open_seq     = seq;
+        state->open_lines   = line_amount;
+        state->open_line    = line_idx;
+    }
+
+    if(++state->open_line == state->open_lines)
+    {
+        state->record_open = false;
+        state->records++;
+        state->threads[thread].records++;
+    }
+}
+
+/// @brief Capture sink callback. Runs under the output mutex.
+static void StressCapture(const uint8_t severity, const char* line, const size_t line_len, void* user_data)
+{
+    StressCheckLine((STRESS_CAPTURE*)user_data, severity, line, line_len);
+}
+
+/// @brief Gets the severity level of a line printed to stdout from its level string, 0 if not found.
+static uint8_t StressLineSeverity(const char* line)
+{
+    static const struct
+    {
+        const char* name;
+        uint8_t     level;
+    } level_names[] =
+    {
+        {"[ERR] ", SVRTY_LVL_ERR},
+        {"[INF] ", SVRTY_LVL_INF},
+        {"[WNG] ", SVRTY_LVL_WNG},
+        {"[DBG] ", SVRTY_LVL_DBG},
+    };
+
+    for(size_t i = 0; i < sizeof(level_names) / sizeof(level_names[0]); i++)
+        if(strstr(line, level_names[i].name) != NULL)
+            return level_names[i].level;
+
+    return 0;
+}
+
+/// @brief Checks a line read from stdout, once its colors and line terminator are removed.
+static void StressOutputLine(char* line, size_t line_len)
+{
+    if(strncmp(line, STRESS_SYNC_MARKER, strlen(STRESS_SYNC_MARKER)) == 0)
+    {
+        __atomic_store_n(&output_synced, strtoull(line + strlen(STRESS_SYNC_MARKER), NULL, 10), __ATOMIC_RELEASE);
+        return;
+    }
+
+    if(line_len > 0 && line[line_len - 1] == STRESS_OUTPUT_CR)
+        line_len--;
+
+    size_t reset_len = strlen(STRESS_COLOR_RESET);
+
+    if(line_len >= reset_len && memcmp(line + line_len - reset_len, STRESS_COLOR_RESET, reset_len) == 0)
+        line_len -= reset_len;
+
+    line[line_len] = '\0';
+
+    StressCheckLine(&output, StressLineSeverity(line), line, line_len);
+}
+
+/// @brief Reads everything printed to stdout (redirected to a pipe) and checks it line by line.
+static void* StressOutputReader(void* arg)
+{
+    static char chunk[STRESS_READ_SIZE];
+    static char line[STRESS_MAX_OUTPUT_LINE + 1];
+    size_t line_len = 0;
+    bool line_too_long = false;
+
+    while(true)
+    {
+        ssize_t read_len = read(output_pipe[0], chunk, sizeof(chunk));
+
+        if(read_len < 0 && errno == EINTR)
+            continue;
+
+        if(read_len <= 0)
+            break;
+
+        for(ssize_t i = 0; i < read_len; i++)
+        {
+            if(chunk[i] != STRESS_LINE_SEPARATOR)
+            {
+                if(line_len < STRESS_MAX_OUTPUT_LINE)
+                    line[line_len++] = chunk[i];
+                else
+                    line_too_long = true;
+
+                continue;
+            }
+
+            // Lines longer than any line ever logged can only come from interleaved writes.
+            if(line_too_long)
+                output.corrupted++;
+            else
+                StressOutputLine(line, line_len);
+
+            line_len        = 0;
+            line_too_long   = false;
+        }
+    }
+
+    return NULL;
+}
+
+/// @brief Waits until the output reader has checked everything printed to stdout so far.
+static void StressSyncOutput(void)
+{
+    SeverityLogFlush();
+    fflush(stdout);
+
+    uint64_t sync_seq = ++output_sync_requested;
+
+    dprintf(STDOUT_FILENO, STRESS_SYNC_FORMAT, sync_seq);
+
+    while(__atomic_load_n(&output_synced, __ATOMIC_ACQUIRE) < sync_seq)
+        usleep(STRESS_SYNC_PERIOD_US);
+}
+
+/// @brief Signal handler. Only there so that logging threads get interrupted, halfway through writes and waits included.
+static void StressSignalHandler(int signal_number)
+{
+    __atomic_fetch_add(&signals_received, 1, __ATOMIC_RELAXED);
+}
+
+/// @brief Logs records_per_thread multi-line records, through SeverityLog and SeverityLogStr, some of them within a logging context.
+static void* StressWorker(void* arg)
+{
+    uint32_t thread     = (uint32_t)(uintptr_t)arg;
+    uint32_t rng_state  = (thread + 1) * 2654435761U;
+    char payload[STRESS_MAX_PAYLOAD];
+    char context[STRESS_CONTEXT_SIZE];
+
+    for(uint32_t seq = 0; seq < records_per_thread; seq++)
+    {
+        size_t payload_len  = StressBuildRecord(payload, thread, seq, &rng_state);
+        uint8_t severity    = StressSeverity(seq);
+        bool with_context   = (seq % 8 == 0);
+        int result;
+
+        if(with_context)
+        {
+            snprintf(context, sizeof(context), "%u", seq);
+            SeverityLogContextPush(STRESS_CONTEXT_KEY, context);
+        }
+
+        if(seq % 4 == 0)
+            result = SeverityLogStr(severity, payload, payload_len);
+        else
+            result = SeverityLog(severity, "%s", payload);
+
+        if(with_context)
+            SeverityLogContextPop();
+
+        if(result < 0)
+            __atomic_fetch_add(&failed_calls, 1, __ATOMIC_RELAXED);
+    }
+
+    __atomic_fetch_add(&workers_done, 1, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+/// @brief Changes every setting that does not discard ERR/INF/WNG logs, as fast as possible, while workers log.
+static void* StressChaos(void* arg)
+{
+    static const uint8_t backends[] = {SVRTY_LOG_BACKEND_STDIO, SVRTY_LOG_BACKEND_WRITEV, SVRTY_LOG_BACKEND_IO_URING};
+
+    uint32_t rng_state = 0x9E3779B9U;
+
+    for(uint32_t i = 0; !__atomic_load_n(&chaos_stop, __ATOMIC_RELAXED); i++)
+    {
+        SetSeverityLogPrintTimeStatus(i & 1);
+        SetSeverityLogPrintTID((i >> 1) & 1);
+        SetSeverityLogMask((i >> 2) & 1 ? SVRTY_LOG_MASK_ALL : SVRTY_LOG_MASK_EIW);
+        SetSeverityLogSamplingRate(SVRTY_LVL_DBG, i % 4);
+        SetSeverityLogBufferSize(STRESS_MIN_BUFFER_SIZE + StressRand(&rng_state) % (STRESS_MAX_BUFFER_SIZE - STRESS_MIN_BUFFER_SIZE));
+
+        // io_uring falls back to writev if not supported. Stdout is never disabled, as every record is checked there.
+        if(i % 16 == 0)
+            SetSeverityLogOutputBackend(backends[(i / 16) % (sizeof(backends) / sizeof(backends[0]))]);
+
+        if(i % 64 == 0)
+            SetSeverityLogPerCpuStaging((i / 64) & 1, 0, NULL, 0);
+
+        // Not checked, as DBG is masked out half of the time.
+        SVRTY_LOG_DBG("Chaos iteration %u", i);
+
+        usleep(STRESS_CHAOS_PERIOD_US);
+    }
+
+    return NULL;
+}
+
+/// @brief Sends signals to random workers until every one of them is done. Workers are
+/// only joined afterwards, as signaling a joined thread is undefined behavior.
+static void* StressSignals(void* arg)
+{
+    uint32_t rng_state = 0x85EBCA6BU;
+
+    while(__atomic_load_n(&workers_done, __ATOMIC_ACQUIRE) < thread_amount)
+    {
+        pthread_kill(workers[StressRand(&rng_state) % thread_amount], STRESS_SIGNAL);
+        usleep(STRESS_SIGNAL_PERIOD_US);
+    }
+
+    return NULL;
+}
+
+/// @brief Restores every setting changed by StressChaos.
+static void StressResetSettings(void)
+{
+    SetSeverityLogPerCpuStaging(false, 0, NULL, 0);
+    SetSeverityLogOutputBackend(SVRTY_LOG_BACKEND_STDIO);
+    SetSeverityLogStdoutStatus(true);
+    SetSeverityLogPrintTimeStatus(true);
+    SetSeverityLogPrintTID(true);
+    SetSeverityLogMask(SVRTY_LOG_MASK_EIW);
+    SetSeverityLogSamplingRate(SVRTY_LVL_DBG, 0);
+    SetSeverityLogBufferSize(STRESS_LOG_BUFFER_SIZE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Tells whether every record logged during a phase was received intact,
+/// in order and without being interleaved. Prints the details too.
+/// @param label What the records were received through.
+/// @param state Checked output state.
+/// @return true if every check passed, false otherwise.
+////////////////////////////////////////////////////////////////////////////////
+static bool StressReport(const char* label, const STRESS_CAPTURE* state)
+{
+    uint64_t missing = 0;
+
+    for(int i = 0; i < thread_amount; i++)
+        missing += records_per_thread - state->threads[i].records;
+
+    fprintf(stderr, STRESS_DETAIL_FORMAT, label, state->records, state->lines, state->corrupted, state->interleaved,
+            state->out_of_order, missing, failed_calls, signals_received);
+
+    return (state->corrupted == 0      &&
+            state->interleaved == 0    &&
+            state->out_of_order == 0   &&
+            missing == 0               &&
+            failed_calls == 0          &&
+            !state->record_open        );
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// @brief Logs from every worker at once and checks that every record reached
+/// both the capture sink and stdout (whatever the backend, staged or not)
+/// intact, in order and without being interleaved.
+/// @param phase Phase settings.
+/// @return true if every check passed, false otherwise.
+//////////////////////////////////////////////////////////////////////////////
+static bool StressRunPhase(const STRESS_PHASE* phase)
+{
+    pthread_t chaos_thread, signal_thread;
+    struct timespec start, end;
+
+    StressResetSettings();
+
+    StressSyncOutput();
+
+    memset(&capture, 0, sizeof(capture));
+    memset(&output, 0, sizeof(output));
+
+    // Staged records are only ordered within their lane, and chaos turns staging on and off.
+    output.lane_order = (phase->staging || phase->chaos);
+    failed_calls        = 0;
+    signals_received    = 0;
+    workers_done        = 0;
+    chaos_stop          = false;
+
+    SetSeverityLogCaptureSink(StressCapture, &capture);
+    SetSeverityLogPerCpuStaging(phase->staging, 0, NULL, 0);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for(int i = 0; i < thread_amount; i++)
+        pthread_create(&workers[i], NULL, StressWorker, (void*)(uintptr_t)i);
+
+    if(phase->chaos)
+    {
+        pthread_create(&chaos_thread, NULL, StressChaos, NULL);
+        pthread_create(&signal_thread, NULL, StressSignals, NULL);
+        pthread_join(signal_thread, NULL);
+    }
+
+    for(int i = 0; i < thread_amount; i++)
+        pthread_join(workers[i], NULL);
+
+    StressSyncOutput();
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if(phase->chaos)
+    {
+        __atomic_store_n(&chaos_stop, true, __ATOMIC_RELAXED);
+        pthread_join(chaos_thread, NULL);
+    }
+
+    StressResetSettings();
+    SetSeverityLogCaptureSink(NULL, NULL);
+
+    double elapsed_ns = ((end.tv_sec - start.tv_sec) * STRESS_NS_PER_SEC) + (end.tv_nsec - start.tv_nsec);
+
+    fprintf(stderr, STRESS_RESULT_FORMAT, phase->name, thread_amount,
+            output.records * STRESS_NS_PER_SEC / elapsed_ns, output.lines * STRESS_NS_PER_SEC / elapsed_ns);
+
+    bool passed = StressReport("stdout", &output);
+
+    passed &= StressReport("capture sink", &capture);
+
+    fprintf(stderr, STRESS_VERDICT_FORMAT, passed ? STRESS_PASSED : STRESS_FAILED);
+
+    return passed;
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+/// @brief Sends SIGTERM to one of a child process' workers while they log, so that
+/// library cleanup (see SeverityLogHandleSignal) runs on a thread that may be in
+/// the middle of a log, and races with the rest. The child must neither crash nor
+/// hang.
+/// @param name Phase name.
+/// @param staging Per-CPU staging enabled (T/F).
+/// @return true if the child exited or was terminated by SIGTERM.
+///////////////////////////////////////////////////////////////////////////////////
+static bool StressRunCleanup(const char* name, const bool staging)
+{
+    pid_t child = fork();
+
+    if(child < 0)
+        return false;
+
+    if(child == 0)
+    {
+        // Child's logs must not reach the output reader.
+        if(freopen(STRESS_NULL_DEVICE, "w", stdout) == NULL)
+            _exit(-1);
+
+        SetSeverityLogPerCpuStaging(staging, 0, NULL, 0);
+
+        for(int i = 0; i < thread_amount; i++)
+            pthread_create(&workers[i], NULL, StressWorker, (void*)(uintptr_t)i);
+
+        usleep(STRESS_CLEANUP_DELAY_US);
+        pthread_kill(workers[0], SIGTERM);
+
+        for(int i = 0; i < thread_amount; i++)
+            pthread_join(workers[i], NULL);
+
+        _exit(0);
+    }
+
+    int status = 0;
+    pid_t waited = 0;
+
+    for(int i = 0; i < STRESS_CLEANUP_TIMEOUT_S * 10 && (waited = waitpid(child, &status, WNOHANG)) == 0; i++)
+        usleep(100000);
+
+    if(waited == 0)
+    {
+        kill(child, SIGKILL);
+        waitpid(child, &status, 0);
+    }
+
+    bool passed = (waited == child && (WIFEXITED(status) || (WIFSIGNALED(status) && WTERMSIG(status) == SIGTERM)));
+
+    fprintf(stderr, STRESS_CLEANUP_FORMAT, name, thread_amount, passed ? STRESS_PASSED : STRESS_FAILED,
+            waited == 0 ? "hung, killed by" : (WIFEXITED(status) ? "exit status" : "terminated by signal"),
+            waited == 0 ? SIGKILL : (WIFEXITED(status) ? WEXITSTATUS(status) : WTERMSIG(status)));
+
+    return passed;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc > 1)
+        thread_amount = atoi(argv[1]);
+
+    if(argc > 2)
+        records_per_thread = (uint32_t)strtoul(argv[2], NULL, 10);
+
+    if(thread_amount <= 0 || thread_amount > STRESS_MAX_THREADS || records_per_thread == 0)
+    {
+        fprintf(stderr, STRESS_USAGE, argv[0]);
+        return -1;
+    }
+
+    // Results are printed to stderr. Logs are read back from stdout and checked.
+    if(pipe(output_pipe) < 0 || dup2(output_pipe[1], STDOUT_FILENO) < 0)
+        return -1;
+
+    close(output_pipe[1]);
+
+    pthread_t output_thread;
+
+    if(pthread_create(&output_thread, NULL, StressOutputReader, NULL) != 0)
+        return -1;
+
+    SeverityLogInitWithMask(STRESS_LOG_BUFFER_SIZE, STRESS_LOG_INIT_MASK);
+
+    // Installed after the library's own handlers, so that it is the one being called.
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = StressSignalHandler;
+    action.sa_flags   = SA_RESTART;   // stdio drops buffered output if a write fails with EINTR.
+    sigemptyset(&action.sa_mask);
+    sigaction(STRESS_SIGNAL, &action, NULL);
+
+    const STRESS_PHASE phases[] =
+    {
+        {"Shared mutex"                 , false , false },
+        {"Per-CPU staging"              , true  , false },
+        {"Settings, resizes, signals"   , false , true  },
+    };
+
+    bool passed = true;
+
+    for(size_t i = 0; i < sizeof(phases) / sizeof(phases[0]); i++)
+        passed &= StressRunPhase(&phases[i]);
+
+    passed &= StressRunCleanup("Cleanup on SIGTERM", false);
+    passed &= StressRunCleanup("Cleanup on SIGTERM, staged", true);
+
+    return (passed ? 0 : -1);
+}
+
+/*************************************/
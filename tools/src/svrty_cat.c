@@ -0,0 +1,100 @@
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "SeverityLogFile_api.h"
+
+/************************************/
+
+/***********************************/
+/******** Define statements ********/
+/***********************************/
+
+#define SVRTY_CAT_USAGE         "Usage: %s <log_file> [from [to]]\n"                                        \
+                                "Prints every record in a SeverityLog file (see SetSeverityLogFileSink).\n" \
+                                "If provided, only records logged between from and to (seconds since\n"     \
+                                "the Epoch, as printed by date +%%s.%%N) are printed. Blocks out of that\n" \
+                                "range are neither read nor decompressed.\n"
+#define SVRTY_CAT_OPEN_ERR      "Could not open <%s> (%d).\n"
+#define SVRTY_CAT_BLOCK_ERR     "Block %" PRIu32 " is corrupted, skipping it.\n"
+#define SVRTY_CAT_RECORD        "%.*s\n"
+
+#define SVRTY_CAT_NS_PER_SEC    1e9
+
+/***********************************/
+
+/*************************************/
+/******* Function definitions ********/
+/*************************************/
+
+/// @brief Converts seconds since the Epoch (as provided in the command line) into nanoseconds.
+static uint64_t ParseTimestamp(const char* seconds)
+{
+    double value_ns = strtod(seconds, NULL) * SVRTY_CAT_NS_PER_SEC;
+
+    if(value_ns <= 0)
+        return 0;
+
+    return (value_ns >= (double)UINT64_MAX ? UINT64_MAX : (uint64_t)value_ns);
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        fprintf(stderr, SVRTY_CAT_USAGE, argv[0]);
+        return -1;
+    }
+
+    uint64_t from_ns    = (argc > 2 ? ParseTimestamp(argv[2]) : 0);
+    uint64_t to_ns      = (argc > 3 ? ParseTimestamp(argv[3]) : UINT64_MAX);
+
+    SVRTY_FILE_READER reader;
+
+    int open_result = SeverityLogFileReaderOpen(&reader, argv[1]);
+
+    if(open_result < 0)
+    {
+        fprintf(stderr, SVRTY_CAT_OPEN_ERR, argv[1], open_result);
+        return -1;
+    }
+
+    // Blocks are sorted by time, so the first one to be read is binary searched.
+    for(uint32_t block = SeverityLogFileReaderFind(&reader, from_ns); block < reader.block_amount; block++)
+    {
+        if(reader.index[block].first_ns > to_ns)
+            break;
+
+        const uint8_t* records;
+        size_t records_length;
+
+        if(SeverityLogFileReaderBlock(&reader, block, &records, &records_length) < 0)
+        {
+            fprintf(stderr, SVRTY_CAT_BLOCK_ERR, block);
+            continue;
+        }
+
+        for(size_t offset = 0; offset + sizeof(SVRTY_FILE_RECORD) <= records_length;)
+        {
+            const SVRTY_FILE_RECORD* record = (const SVRTY_FILE_RECORD*)(records + offset);
+
+            if(record->length > records_length - offset - sizeof(SVRTY_FILE_RECORD))
+                break;
+
+            if(record->timestamp_ns >= from_ns && record->timestamp_ns <= to_ns)
+                printf(SVRTY_CAT_RECORD, (int)record->length, record->line);
+
+            offset += SVRTY_FILE_RECORD_SIZE(record->length);
+        }
+    }
+
+    SeverityLogFileReaderClose(&reader);
+
+    return 0;
+}
+
+/*************************************/
@@ -0,0 +1,209 @@
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "SeverityLogFile_api.h"
+
+/************************************/
+
+/***********************************/
+/******** Define statements ********/
+/***********************************/
+
+#define SVRTY_QUERY_USAGE       "Usage: %s <log_file> <from> <to> [levels]\n"                                   \
+                                "Prints records in a SeverityLog file (see SetSeverityLogFileSink) logged\n"    \
+                                "between from and to (seconds since the Epoch, as printed by date +%%s.%%N).\n" \
+                                "levels is a comma separated list of severity levels to be printed (such as\n"  \
+                                "ERR,WNG), every level is printed if not provided. The sidecar index (see\n"    \
+                                "SetSeverityLogFileSidecarIndex) is used to seek straight to the first\n"       \
+                                "matching record, and to skip spans holding none of the requested levels.\n"
+#define SVRTY_QUERY_OPEN_ERR    "Could not open <%s> (%d).\n"
+#define SVRTY_QUERY_LEVEL_ERR   "Unknown severity level <%s>.\n"
+#define SVRTY_QUERY_NO_SIDECAR  "No sidecar index found for <%s>, using the block index instead.\n"
+#define SVRTY_QUERY_BLOCK_ERR   "Block at offset %" PRIu64 " is corrupted, skipping it.\n"
+#define SVRTY_QUERY_RECORD      "%.*s\n"
+#define SVRTY_QUERY_SEPARATORS  ","
+
+#define SVRTY_QUERY_NS_PER_SEC  1e9
+#define SVRTY_QUERY_ALL_RECORDS UINT32_MAX
+
+/***********************************/
+
+/*************************************/
+/******* Function definitions ********/
+/*************************************/
+
+/// @brief Converts seconds since the Epoch (as provided in the command line) into nanoseconds.
+static uint64_t ParseTimestamp(const char* seconds)
+{
+    double value_ns = strtod(seconds, NULL) * SVRTY_QUERY_NS_PER_SEC;
+
+    if(value_ns <= 0)
+        return 0;
+
+    return (value_ns >= (double)UINT64_MAX ? UINT64_MAX : (uint64_t)value_ns);
+}
+
+/// @brief Converts a comma separated list of severity levels into a mask (see SVRTY_FILE_SEVERITY_BIT), 0 if any of them is unknown.
+static uint8_t ParseLevels(char* levels)
+{
+    static const struct
+    {
+        const char* name;
+        uint8_t     level;
+    } level_names[] =
+    {
+        {"ERR", SVRTY_LVL_ERR},
+        {"INF", SVRTY_LVL_INF},
+        {"WNG", SVRTY_LVL_WNG},
+        {"DBG", SVRTY_LVL_DBG},
+    };
+
+    uint8_t mask = 0;
+
+    for(char* level = strtok(levels, SVRTY_QUERY_SEPARATORS); level != NULL; level = strtok(NULL, SVRTY_QUERY_SEPARATORS))
+    {
+        size_t i = 0;
+
+        while(i < sizeof(level_names) / sizeof(level_names[0]) && strcmp(level, level_names[i].name) != 0)
+            i++;
+
+        if(i == sizeof(level_names) / sizeof(level_names[0]))
+        {
+            fprintf(stderr, SVRTY_QUERY_LEVEL_ERR, level);
+            return 0;
+        }
+
+        mask |= (uint8_t)SVRTY_FILE_SEVERITY_BIT(level_names[i].level);
+    }
+
+    return mask;
+}
+
+/// @brief Prints up to record_amount records (within a decompressed block) matching the requested time range and levels.
+static void PrintRecords(const uint8_t* records, const size_t records_length, uint32_t record_amount, const uint64_t from_ns, const uint64_t to_ns, const uint8_t level_mask)
+{
+    for(size_t offset = 0; record_amount > 0 && offset + sizeof(SVRTY_FILE_RECORD) <= records_length; record_amount--)
+    {
+        const SVRTY_FILE_RECORD* record = (const SVRTY_FILE_RECORD*)(records + offset);
+
+        if(record->length > records_length - offset - sizeof(SVRTY_FILE_RECORD))
+            break;
+
+        if( record->timestamp_ns >= from_ns                         &&
+            record->timestamp_ns <= to_ns                           &&
+            (level_mask & SVRTY_FILE_SEVERITY_BIT(record->severity))    )
+            printf(SVRTY_QUERY_RECORD, (int)record->length, record->line);
+
+        offset += SVRTY_FILE_RECORD_SIZE(record->length);
+    }
+}
+
+/// @brief Seeks to the first span holding records logged at (or after) from_ns through the sidecar index, and reads spans from there on.
+static void QuerySidecar(SVRTY_FILE_READER* reader, const SVRTY_FILE_SIDECAR* sidecar, const uint64_t from_ns, const uint64_t to_ns, const uint8_t level_mask)
+{
+    uint64_t loaded_offset = UINT64_MAX;
+    const uint8_t* records = NULL;
+    size_t records_length = 0;
+
+    for(uint32_t entry = SeverityLogFileSidecarFind(sidecar, from_ns); entry < sidecar->entry_amount; entry++)
+    {
+        const SVRTY_FILE_SIDECAR_ENTRY* span = &sidecar->entries[entry];
+
+        if(span->timestamp_ns > to_ns)
+            break;
+
+        // Blocks are only read (and decompressed) if any of their spans holds a requested level.
+        if((span->severity_mask & level_mask) == 0)
+            continue;
+
+        if(span->block_offset != loaded_offset)
+        {
+            if(SeverityLogFileReaderBlockAt(reader, span->block_offset, &records, &records_length) < 0)
+            {
+                fprintf(stderr, SVRTY_QUERY_BLOCK_ERR, span->block_offset);
+                loaded_offset = UINT64_MAX;
+                continue;
+            }
+
+            loaded_offset = span->block_offset;
+        }
+
+        if(span->record_offset < records_length)
+            PrintRecords(records + span->record_offset, records_length - span->record_offset, span->record_amount, from_ns, to_ns, level_mask);
+    }
+}
+
+/// @brief Same as QuerySidecar, through the block index (for files written without a sidecar index).
+static void QueryBlocks(SVRTY_FILE_READER* reader, const uint64_t from_ns, const uint64_t to_ns, const uint8_t level_mask)
+{
+    for(uint32_t block = SeverityLogFileReaderFind(reader, from_ns); block < reader->block_amount; block++)
+    {
+        if(reader->index[block].first_ns > to_ns)
+            break;
+
+        const uint8_t* records;
+        size_t records_length;
+
+        if(SeverityLogFileReaderBlock(reader, block, &records, &records_length) < 0)
+        {
+            fprintf(stderr, SVRTY_QUERY_BLOCK_ERR, reader->index[block].offset);
+            continue;
+        }
+
+        PrintRecords(records, records_length, SVRTY_QUERY_ALL_RECORDS, from_ns, to_ns, level_mask);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 4)
+    {
+        fprintf(stderr, SVRTY_QUERY_USAGE, argv[0]);
+        return -1;
+    }
+
+    uint64_t from_ns    = ParseTimestamp(argv[2]);
+    uint64_t to_ns      = ParseTimestamp(argv[3]);
+    uint8_t level_mask  = (argc > 4 ? ParseLevels(argv[4]) : UINT8_MAX);
+
+    if(level_mask == 0)
+    {
+        fprintf(stderr, SVRTY_QUERY_USAGE, argv[0]);
+        return -1;
+    }
+
+    SVRTY_FILE_READER reader;
+
+    int open_result = SeverityLogFileReaderOpen(&reader, argv[1]);
+
+    if(open_result < 0)
+    {
+        fprintf(stderr, SVRTY_QUERY_OPEN_ERR, argv[1], open_result);
+        return -1;
+    }
+
+    SVRTY_FILE_SIDECAR sidecar;
+
+    if(SeverityLogFileSidecarOpen(&sidecar, argv[1]) == SVRTY_FILE_SUCCESS)
+    {
+        QuerySidecar(&reader, &sidecar, from_ns, to_ns, level_mask);
+        SeverityLogFileSidecarClose(&sidecar);
+    }
+    else
+    {
+        fprintf(stderr, SVRTY_QUERY_NO_SIDECAR, argv[1]);
+        QueryBlocks(&reader, from_ns, to_ns, level_mask);
+    }
+
+    SeverityLogFileReaderClose(&reader);
+
+    return 0;
+}
+
+/*************************************/
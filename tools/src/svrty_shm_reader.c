@@ -0,0 +1,125 @@
+/************************************/
+/******** Include statements ********/
+/************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <signal.h>
+#include <inttypes.h>
+#include "SeverityLogShm_api.h"
+
+/************************************/
+
+/***********************************/
+/******** Define statements ********/
+/***********************************/
+
+#define SHM_READER_USAGE        "Usage: %s <shm_name> [idle_timeout_ms]\n"                  \
+                                "Prints every record published into a SeverityLog shared\n" \
+                                "memory ring. Runs until interrupted, or until no record\n" \
+                                "is published for idle_timeout_ms (if provided).\n"
+#define SHM_READER_OPEN_ERR     "Could not attach to <%s> ring (%d).\n"
+#define SHM_READER_RECORD       "[%" PRIu64 ".%09" PRIu64 "] [%s] [%" PRIu32 ":%" PRIu32 "] "
+#define SHM_READER_CONTEXT      "[%.*s] "
+#define SHM_READER_PAYLOAD      "%s\n"
+#define SHM_READER_SUMMARY      "Lost records: %" PRIu64 ". Overwritten records: %" PRIu64 ". Skipped records: %" PRIu64 ".\n"
+
+#define SHM_READER_POLL_MS      200
+#define SHM_READER_NS_PER_SEC   ((uint64_t)1000000000)
+
+/***********************************/
+
+/***********************************/
+/******** Private variables ********/
+/***********************************/
+
+static volatile sig_atomic_t keep_reading = 1;
+
+/***********************************/
+
+/*************************************/
+/******* Function definitions ********/
+/*************************************/
+
+/// @brief Stops the reading loop.
+static void StopReading(int signal_number)
+{
+    keep_reading = 0;
+}
+
+/// @brief Gets the string printed for a given severity level.
+static const char* SeverityString(const uint8_t severity)
+{
+    switch(severity)
+    {
+        case SVRTY_LVL_ERR: return "ERR";
+        case SVRTY_LVL_INF: return "INF";
+        case SVRTY_LVL_WNG: return "WNG";
+        case SVRTY_LVL_DBG: return "DBG";
+        default:            return "???";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        fprintf(stderr, SHM_READER_USAGE, argv[0]);
+        return -1;
+    }
+
+    int idle_timeout_ms = (argc > 2 ? atoi(argv[2]) : -1);
+
+    SVRTY_SHM_READER reader;
+
+    int open_result = SeverityLogShmReaderOpen(&reader, argv[1]);
+
+    if(open_result < 0)
+    {
+        fprintf(stderr, SHM_READER_OPEN_ERR, argv[1], open_result);
+        return -1;
+    }
+
+    signal(SIGINT, StopReading);
+    signal(SIGTERM, StopReading);
+
+    int idle_ms = 0;
+
+    while(keep_reading && (idle_timeout_ms < 0 || idle_ms < idle_timeout_ms))
+    {
+        const SVRTY_SHM_RECORD* record;
+
+        // Short waits, so that signals are noticed even if nothing is published.
+        if(SeverityLogShmReaderNext(&reader, &record, SHM_READER_POLL_MS) < 0)
+        {
+            idle_ms += SHM_READER_POLL_MS;
+            continue;
+        }
+
+        idle_ms = 0;
+
+        // Printed straight from the ring (no copies). If it was overwritten meanwhile, it is counted as lost.
+        printf( SHM_READER_RECORD                                   ,
+                record->timestamp_ns / SHM_READER_NS_PER_SEC        ,
+                record->timestamp_ns % SHM_READER_NS_PER_SEC        ,
+                SeverityString(record->severity)                    ,
+                record->pid                                         ,
+                record->tid                                         );
+
+        if(record->context_length > 0)
+            printf(SHM_READER_CONTEXT, (int)record->context_length, record->payload);
+
+        printf(SHM_READER_PAYLOAD, record->payload + record->context_length);
+
+        SeverityLogShmReaderRelease(&reader);
+    }
+
+    fprintf(stderr, SHM_READER_SUMMARY, reader.lost, reader.header->overwritten, reader.header->skipped);
+
+    SeverityLogShmReaderClose(&reader);
+
+    return 0;
+}
+
+/*************************************/